@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "brainEvaluation.h"
+#include "neuralNetworkShell.h"
+#include "snakeGame.h"
+#include "main.h"
+
+struct evaluationJob {
+	const char* directory;
+	brainResult* results;
+	int brainCount;
+	int games;
+	unsigned int seed;
+	int nextBrain;				//the next brain to be picked up by a worker
+	pthread_mutex_t lock;
+};
+typedef struct evaluationJob evaluationJob;
+
+static int compareDoubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static int compareResults(const void* a, const void* b) {
+	const brainResult* x = a;
+	const brainResult* y = b;
+	if (x->loaded != y->loaded)
+		return y->loaded - x->loaded;
+	if (x->meanScore != y->meanScore)
+		return x->meanScore < y->meanScore ? 1 : -1;
+	if (x->meanTime != y->meanTime)
+		return x->meanTime < y->meanTime ? 1 : -1;
+	return strcmp(x->name, y->name);
+}
+
+/**
+ * @brief This function works out the mean, median and variance of some samples, the samples get sorted
+ * @param samples - the samples
+ * @param count - the number of samples
+ * @param mean - where the mean is stored
+ * @param median - where the median is stored
+ * @param variance - where the variance is stored
+ * @return nothing
+ */
+static void summarise(double* samples, int count, double* mean, double* median, double* variance) {
+	double sum = 0;
+	for (int i = 0; i < count; i++)
+		sum += samples[i];
+	*mean = sum / count;
+
+	double squares = 0;
+	for (int i = 0; i < count; i++)
+		squares += (samples[i] - *mean) * (samples[i] - *mean);
+	*variance = squares / count;
+
+	qsort(samples, count, sizeof(double), compareDoubles);
+	*median = count % 2 ? samples[count/2] : (samples[count/2 - 1] + samples[count/2]) / 2;
+}
+
+/**
+ * @brief This function checks whether a file starts with a network layout that can play the game,
+ * 		  so the replays and other files saved next to the brains are left out of the leaderboard
+ * @param path - the file
+ * @return 1 if the first line is a playable layout, 0 otherwise
+ */
+static int isBrainFile(const char* path) {
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+		return 0;
+
+	char line[4096];
+	int read = fgets(line, sizeof(line), f) != NULL;
+	fclose(f);
+	if (!read)
+		return 0;
+
+	int layout[NETWORK_MAX_LAYERS];
+	int networkSize = 0;
+	for (char* token = strtok(line, ",\r\n"); token; token = strtok(NULL, ",\r\n")) {
+		char* e;
+		long size = strtol(token, &e, 10);
+		if (e == token || *e || networkSize == NETWORK_MAX_LAYERS)
+			return 0;
+		layout[networkSize++] = size < 0 || size > NETWORK_MAX_WIDTH ? 0 : size;
+	}
+	return playableLayout(layout, networkSize);
+}
+
+/**
+ * @brief This function loads one brain and plays the seeded games with it
+ * @param job - the evaluation being run
+ * @param result - where the brains statistics are stored, its name is already set
+ * @return nothing
+ */
+static void evaluateBrain(evaluationJob* job, brainResult* result) {
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", job->directory, result->name);
+
+	//mapBrain turns down layouts that can't play the game
+	neuralNetwork nn;
+	if (!mapBrain(&nn, path))
+		return;
+
+	snake s;
+	board b;
+	double* scores = malloc(job->games * sizeof(double));
+	double* times = malloc(job->games * sizeof(double));
+
+	//every brain plays the same seeds, so they are all ranked on the same games
+	for (int i = 0; i < job->games; i++) {
+		b.seed = job->seed + i;
+		playCompTrain(&nn, &s, &b, NULL, NULL);
+		scores[i] = s.score;
+		times[i] = s.time;
+		free(s.x);
+		free(s.y);
+	}
+
+	summarise(scores, job->games, &result->meanScore, &result->medianScore, &result->scoreVariance);
+	summarise(times, job->games, &result->meanTime, &result->medianTime, &result->timeVariance);
+	result->loaded = 1;
+
+	free(scores);
+	free(times);
+	destroyBrainData(&nn);
+}
+
+/**
+ * @brief This function is run by each worker thread, it takes brains off the list until there are none left
+ * @param arg - the evaluationJob
+ * @return nothing
+ */
+static void* evaluationWorker(void* arg) {
+	evaluationJob* job = arg;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		int brain = job->nextBrain++;
+		pthread_mutex_unlock(&job->lock);
+
+		if (brain >= job->brainCount)
+			return NULL;
+		evaluateBrain(job, &job->results[brain]);
+	}
+}
+
+/**
+ * @brief This function plays a set of seeded games with every brain in a directory, across all
+ * 		  cores, and prints a leaderboard sorted by mean score.
+ * @param directory - the directory holding the brain files
+ * @param games - the number of games each brain plays
+ * @param seed - the seed of the first game, game i uses seed + i
+ * @param threads - the number of worker threads, 0 uses one per core
+ * @return 1 if all went well, 0 if the directory could not be read
+ */
+int evaluateBrains(const char* directory, int games, unsigned int seed, int threads) {
+	DIR* dir = opendir(directory);
+	if (dir == NULL) {
+		printf("Could not open %s\n", directory);
+		return 0;
+	}
+
+	evaluationJob job = {0};
+	int capacity = 64;
+	job.results = calloc(capacity, sizeof(brainResult));
+	job.directory = directory;
+	job.games = games;
+	job.seed = seed;
+	pthread_mutex_init(&job.lock, NULL);
+
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		char path[4096];
+		struct stat info;
+		snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+		if (entry->d_name[0] == '.' || stat(path, &info) != 0 || !S_ISREG(info.st_mode) || !isBrainFile(path))
+			continue;
+
+		if (job.brainCount == capacity) {
+			capacity *= 2;
+			job.results = realloc(job.results, capacity * sizeof(brainResult));
+		}
+		memset(&job.results[job.brainCount], 0, sizeof(brainResult));
+		snprintf(job.results[job.brainCount].name, sizeof(job.results[0].name), "%s", entry->d_name);
+		job.brainCount++;
+	}
+	closedir(dir);
+
+	if (threads <= 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads > job.brainCount)
+		threads = job.brainCount;
+
+	struct timespec start, finish;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pthread_t* workers = calloc(threads, sizeof(pthread_t));
+	for (int i = 0; i < threads; i++)
+		pthread_create(&workers[i], NULL, evaluationWorker, &job);
+	for (int i = 0; i < threads; i++)
+		pthread_join(workers[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	double seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+	qsort(job.results, job.brainCount, sizeof(brainResult), compareResults);
+
+	printf("%-6s %-24s %10s %10s %12s %10s %10s %12s\n",
+		"Rank", "Brain", "Mean", "Median", "Variance", "Time", "Median", "Variance");
+	for (int i = 0; i < job.brainCount; i++) {
+		brainResult* r = &job.results[i];
+		if (!r->loaded) {
+			printf("%-6s %-24s could not be loaded\n", "-", r->name);
+			continue;
+		}
+		printf("%-6d %-24s %10.2lf %10.1lf %12.2lf %10.1lf %10.1lf %12.1lf\n", i+1, r->name,
+			r->meanScore, r->medianScore, r->scoreVariance, r->meanTime, r->medianTime, r->timeVariance);
+	}
+	printf("Evaluated %d brains x %d games on %d threads in %.2lfs\n", job.brainCount, games, threads, seconds);
+
+	pthread_mutex_destroy(&job.lock);
+	free(workers);
+	free(job.results);
+	return 1;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+struct brainResult {
+	char name[256];
+	int loaded;				//0 if the file was not a valid brain
+	double meanScore;
+	double medianScore;
+	double scoreVariance;
+	double meanTime;
+	double medianTime;
+	double timeVariance;
+};
+typedef struct brainResult brainResult;
+
+int evaluateBrains(const char*, int, unsigned int, int);
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "curriculum.h"
+#include "snakeGame.h"
+#include "main.h"
+
+/**
+ * @brief This function sets a stage
+ * @param stage - the stage
+ * @param width - the board width in cells
+ * @param height - the board height in cells
+ * @param startBudget - ticks to find the first food
+ * @param foodBudget - ticks added for each food
+ * @param promoteFitness - the median fitness that moves training on to the next stage
+ * @return nothing
+ */
+static void setStage(curriculumStage* stage, int width, int height, int startBudget, int foodBudget, double promoteFitness) {
+	stage->width = width;
+	stage->height = height;
+	stage->startBudget = startBudget;
+	stage->foodBudget = foodBudget;
+	stage->promoteFitness = promoteFitness;
+	stage->startGeneration = -1;
+}
+
+/**
+ * @brief This function adds the last stage, the board set by setBoardSize with the usual budgets
+ * @param c - the curriculum, it must have room for another stage
+ * @return nothing
+ */
+static void addFinalStage(curriculum* c) {
+	int width, height;
+	getBoardSize(&width, &height);
+	setStage(&c->stages[c->count++], width, height, STARVATION_BUDGET, FOOD_BUDGET, 0);
+}
+
+/**
+ * @brief This function sets up the default curriculum, an 8x8 board and then a 16x16 board with
+ * 		  shorter budgets, before the full board. Stages no smaller than the full board are left out.
+ * @param c - the curriculum
+ * @return nothing
+ */
+void initialiseCurriculum(curriculum* c) {
+	int width, height;
+	getBoardSize(&width, &height);
+
+	c->count = 0;
+	c->stage = 0;
+	if (width > 8 && height > 8)
+		setStage(&c->stages[c->count++], 8, 8, 20, 40, 16);
+	if (width > 16 && height > 16)
+		setStage(&c->stages[c->count++], 16, 16, 35, 100, 64);
+	addFinalStage(c);
+}
+
+/**
+ * @brief This function reads a curriculum from the command line, the stages before the full board
+ * 		  separated by commas, each one size[xheight]:startBudget:foodBudget:promoteFitness,
+ * 		  e.g. 8:20:40:16,16:35:100:64
+ * @param c - the curriculum
+ * @param text - the stages
+ * @return 1 if all went well, 0 if a stage could not be read
+ */
+int parseCurriculum(curriculum* c, const char* text) {
+	c->count = 0;
+	c->stage = 0;
+
+	while (*text) {
+		int width, height, startBudget, foodBudget, used;
+		double promoteFitness;
+		if (c->count == CURRICULUM_MAX_STAGES - 1) {
+			printf("A curriculum can have at most %d stages\n", CURRICULUM_MAX_STAGES - 1);
+			return 0;
+		}
+
+		if (sscanf(text, "%dx%d:%d:%d:%lf%n", &width, &height, &startBudget, &foodBudget, &promoteFitness, &used) != 5) {
+			if (sscanf(text, "%d:%d:%d:%lf%n", &width, &startBudget, &foodBudget, &promoteFitness, &used) != 4) {
+				printf("Could not read the curriculum stage %s\n", text);
+				return 0;
+			}
+			height = width;
+		}
+
+		if (width < BOARD_MIN_SIZE || width > BOARD_MAX_SIZE || height < BOARD_MIN_SIZE || height > BOARD_MAX_SIZE ||
+			startBudget < 1 || foodBudget < 0) {
+			printf("Could not read the curriculum stage %s\n", text);
+			return 0;
+		}
+
+		setStage(&c->stages[c->count++], width, height, startBudget, foodBudget, promoteFitness);
+		text += used;
+		if (*text == ',')
+			text++;
+	}
+
+	addFinalStage(c);
+	return 1;
+}
+
+/**
+ * @brief This function makes the games played from now on use the current stages board and budgets
+ * @param c - the curriculum
+ * @param generation - the generation the stage starts at
+ * @return nothing
+ */
+void startCurriculumStage(curriculum* c, int generation) {
+	curriculumStage* stage = &c->stages[c->stage];
+	stage->startGeneration = generation;
+	setBoardSize(stage->width, stage->height);
+	setStarvationBudget(stage->startBudget, stage->foodBudget);
+
+	printf("Curriculum stage %d/%d from generation %d: %dx%d board, %d ticks to find food, %d more per food\n",
+		c->stage + 1, c->count, generation, stage->width, stage->height, stage->startBudget, stage->foodBudget);
+}
+
+/**
+ * @brief This function moves training on to the next stage if a generation did well enough
+ * @param c - the curriculum
+ * @param fitness - the median fitness of the generation
+ * @param generation - the generation
+ * @return 1 if training moved on, 0 otherwise
+ */
+int promoteCurriculum(curriculum* c, double fitness, int generation) {
+	if (curriculumFinished(c) || fitness < c->stages[c->stage].promoteFitness)
+		return 0;
+
+	c->stage++;
+	startCurriculumStage(c, generation + 1);
+	return 1;
+}
+
+/**
+ * @brief This function checks whether training has reached the last stage, the full board
+ * @param c - the curriculum
+ * @return 1 if it has, 0 otherwise
+ */
+int curriculumFinished(curriculum* c) {
+	return c->stage == c->count - 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#define STARVATION_BUDGET 50			//ticks a training snake has to find its first food
+#define FOOD_BUDGET 150					//ticks added each time it eats
+#define CURRICULUM_MAX_STAGES 8
+
+struct curriculumStage {
+	int width;							//the board, in cells
+	int height;
+	int startBudget;					//the starvation budgets playCompTrain uses on this stage
+	int foodBudget;
+	double promoteFitness;				//median fitness that moves training on, unused on the last stage
+	int startGeneration;				//when training reached this stage, -1 if it hasn't
+};
+typedef struct curriculumStage curriculumStage;
+
+/*
+	Training starts on the first stage and moves on to the next the first generation whose median
+	fitness reaches the stages promoteFitness. The last stage is always the board set with --board
+	and the usual budgets, so a curriculum only changes how training gets there.
+*/
+struct curriculum {
+	curriculumStage stages[CURRICULUM_MAX_STAGES];
+	int count;
+	int stage;							//the stage being trained on
+};
+typedef struct curriculum curriculum;
+
+void initialiseCurriculum(curriculum*);
+int parseCurriculum(curriculum*, const char*);
+void startCurriculumStage(curriculum*, int);
+int promoteCurriculum(curriculum*, double, int);
+int curriculumFinished(curriculum*);
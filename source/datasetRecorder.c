@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef DATASET_ZLIB
+#include <zlib.h>
+#endif
+
+#include "datasetRecorder.h"
+#include "snakeGame.h"
+
+/**
+ * @brief This function allocates an empty row buffer
+ * @param capacity - the number of rows it can hold before growing
+ * @return the buffer
+ */
+static datasetBuffer* createDatasetBuffer(int capacity) {
+	datasetBuffer* buffer = calloc(1, sizeof(datasetBuffer));
+	buffer->capacity = capacity;
+	buffer->features = malloc((size_t)capacity * DATASET_FEATURES * sizeof(float));
+	buffer->scores = malloc(capacity * sizeof(int32_t));
+	buffer->moves = malloc(capacity);
+	buffer->died = malloc(capacity);
+	return buffer;
+}
+
+static void destroyDatasetBuffer(datasetBuffer* buffer) {
+	free(buffer->features);
+	free(buffer->scores);
+	free(buffer->moves);
+	free(buffer->died);
+	free(buffer);
+}
+
+/**
+ * @brief This function lays a buffer out in columns, compresses it if asked to and writes it as one chunk.
+ * 		  Only ever called from the writer thread.
+ * @param d - the recorder
+ * @param buffer - the full buffer
+ * @param columns - scratch space for the columns, grown as needed
+ * @param columnsSize - the size of columns
+ * @return nothing
+ */
+static void writeDatasetChunk(datasetRecorder* d, datasetBuffer* buffer, uint8_t** columns, size_t* columnsSize) {
+	static const uint8_t padding[8] = {0};
+	int rows = buffer->rows;
+	size_t rawSize = (size_t)rows * (DATASET_FEATURES * sizeof(float) + sizeof(int32_t) + 2);
+	if (rawSize > *columnsSize) {
+		*columnsSize = rawSize;
+		*columns = realloc(*columns, rawSize);
+	}
+
+	//transpose the feature rows into one column per feature
+	float* features = (float*)*columns;
+	for (int i = 0; i < rows; i++)
+		for (int j = 0; j < DATASET_FEATURES; j++)
+			features[(size_t)j * rows + i] = buffer->features[(size_t)i * DATASET_FEATURES + j];
+
+	uint8_t* p = *columns + (size_t)rows * DATASET_FEATURES * sizeof(float);
+	memcpy(p, buffer->scores, rows * sizeof(int32_t));
+	p += rows * sizeof(int32_t);
+	memcpy(p, buffer->moves, rows);
+	p += rows;
+	memcpy(p, buffer->died, rows);
+
+	datasetChunkHeader header = {DATASET_CHUNK_MAGIC, rows, 0, rawSize, rawSize};
+	const uint8_t* stored = *columns;
+	uint8_t* packed = NULL;
+
+#ifdef DATASET_ZLIB
+	if (d->compress) {
+		uLongf packedSize = compressBound(rawSize);
+		packed = malloc(packedSize);
+		if (compress2(packed, &packedSize, *columns, rawSize, Z_BEST_SPEED) == Z_OK && packedSize < rawSize) {
+			header.compressed = 1;
+			header.storedSize = packedSize;
+			stored = packed;
+		}
+	}
+#endif
+
+	size_t dataSize = header.storedSize;
+	header.storedSize = (dataSize + 7) & ~(size_t)7;
+
+	fwrite(&header, sizeof(header), 1, d->f);
+	fwrite(stored, 1, dataSize, d->f);
+	fwrite(padding, 1, header.storedSize - dataSize, d->f);
+	free(packed);
+
+	d->storedBytes += sizeof(header) + header.storedSize;
+	d->chunks++;
+	d->rows += rows;
+}
+
+/**
+ * @brief This function is the writer thread, it writes full buffers in the order they were handed
+ * 		  over and then gives them back to the recorder.
+ * @param arg - the recorder
+ * @return nothing
+ */
+static void* datasetWriter(void* arg) {
+	datasetRecorder* d = arg;
+	uint8_t* columns = NULL;
+	size_t columnsSize = 0;
+
+	pthread_mutex_lock(&d->lock);
+	while (1) {
+		while (!d->fullCount && !d->closing)
+			pthread_cond_wait(&d->changed, &d->lock);
+		if (!d->fullCount)
+			break;
+
+		datasetBuffer* buffer = d->full[0];
+		d->fullCount--;
+		memmove(d->full, d->full + 1, d->fullCount * sizeof(datasetBuffer*));
+		pthread_mutex_unlock(&d->lock);
+
+		writeDatasetChunk(d, buffer, &columns, &columnsSize);
+
+		pthread_mutex_lock(&d->lock);
+		buffer->rows = 0;
+		d->empty[d->emptyCount++] = buffer;
+		pthread_cond_broadcast(&d->changed);
+	}
+	pthread_mutex_unlock(&d->lock);
+
+	fflush(d->f);
+	free(columns);
+	return NULL;
+}
+
+/**
+ * @brief This function creates a dataset file and starts its writer thread
+ * @param filePath - the file to write, replaced if it exists
+ * @param sampleRate - the fraction of ticks that are recorded, from 0 to 1
+ * @param compress - if not 0 chunks are deflated, only if built with DATASET_ZLIB
+ * @return the recorder, or NULL if the file could not be created
+ */
+datasetRecorder* openDataset(const char* filePath, double sampleRate, int compress) {
+	FILE* f = fopen(filePath, "wb");
+	if (f == NULL) {
+		printf("Could not create %s\n", filePath);
+		return NULL;
+	}
+
+#ifndef DATASET_ZLIB
+	if (compress)
+		printf("Built without DATASET_ZLIB, the dataset will not be compressed\n");
+#endif
+
+	datasetRecorder* d = calloc(1, sizeof(datasetRecorder));
+	d->f = f;
+	d->compress = compress;
+	d->threshold = sampleRate >= 1 ? 1ull << 32 : sampleRate <= 0 ? 0 : (uint64_t)(sampleRate * 4294967296.0);
+	d->random = 0x9e3779b97f4a7c15ull ^ (uint64_t)rand();
+	d->current = createDatasetBuffer(DATASET_CHUNK_ROWS);
+	for (int i = 0; i < DATASET_BUFFERS - 1; i++)
+		d->empty[d->emptyCount++] = createDatasetBuffer(DATASET_CHUNK_ROWS);
+
+	datasetFileHeader header = {DATASET_MAGIC, DATASET_FEATURES};
+	fwrite(&header, sizeof(header), 1, f);
+
+	pthread_mutex_init(&d->lock, NULL);
+	pthread_cond_init(&d->changed, NULL);
+	pthread_create(&d->writer, NULL, datasetWriter, d);
+	return d;
+}
+
+/**
+ * @brief This function samples the current tick, if it is picked its inputs and move are buffered
+ * 		  until the game ends and its outcome is known
+ * @param d - the recorder
+ * @param inputs - the DATASET_FEATURES network inputs for this tick
+ * @param move - the move the network chose, 0 left, 1 forward, 2 right
+ * @return nothing
+ */
+void recordDatasetTick(datasetRecorder* d, const double* inputs, int move) {
+	d->random ^= d->random << 13;
+	d->random ^= d->random >> 7;
+	d->random ^= d->random << 17;
+	if ((d->random >> 32) >= d->threshold)
+		return;
+
+	datasetBuffer* buffer = d->current;
+	if (buffer->rows == buffer->capacity) {
+		buffer->capacity *= 2;
+		buffer->features = realloc(buffer->features, (size_t)buffer->capacity * DATASET_FEATURES * sizeof(float));
+		buffer->scores = realloc(buffer->scores, buffer->capacity * sizeof(int32_t));
+		buffer->moves = realloc(buffer->moves, buffer->capacity);
+		buffer->died = realloc(buffer->died, buffer->capacity);
+	}
+
+	float* row = &buffer->features[(size_t)buffer->rows * DATASET_FEATURES];
+	for (int i = 0; i < DATASET_FEATURES; i++)
+		row[i] = inputs[i];
+	buffer->moves[buffer->rows++] = move;
+}
+
+/**
+ * @brief This function fills in the outcome of every tick recorded in the game that just ended,
+ * 		  and hands the buffer to the writer once it is full
+ * @param d - the recorder
+ * @param s - the snake at the end of the game
+ * @return nothing
+ */
+void finishDatasetGame(datasetRecorder* d, snake* s) {
+	datasetBuffer* buffer = d->current;
+	for (int i = d->gameStart; i < buffer->rows; i++) {
+		buffer->scores[i] = s->score;
+		buffer->died[i] = !s->alive;
+	}
+	d->gameStart = buffer->rows;
+
+	if (buffer->rows < DATASET_CHUNK_ROWS)
+		return;
+
+	//only waits if the writer is DATASET_BUFFERS - 1 chunks behind
+	pthread_mutex_lock(&d->lock);
+	while (!d->emptyCount)
+		pthread_cond_wait(&d->changed, &d->lock);
+	d->full[d->fullCount++] = buffer;
+	d->current = d->empty[--d->emptyCount];
+	pthread_cond_broadcast(&d->changed);
+	pthread_mutex_unlock(&d->lock);
+
+	d->gameStart = 0;
+}
+
+/**
+ * @brief This function writes out whatever is buffered, stops the writer and closes the file.
+ * 		  Ticks from a game that was never finished are dropped.
+ * @param d - the recorder, freed by this function
+ * @return nothing
+ */
+void closeDataset(datasetRecorder* d) {
+	pthread_mutex_lock(&d->lock);
+	d->current->rows = d->gameStart;
+	if (d->current->rows)
+		d->full[d->fullCount++] = d->current;
+	else
+		d->empty[d->emptyCount++] = d->current;
+	d->closing = 1;
+	pthread_cond_broadcast(&d->changed);
+	pthread_mutex_unlock(&d->lock);
+
+	pthread_join(d->writer, NULL);
+	printf("Recorded %lld ticks in %lld chunks, %.1lfMB\n", d->rows, d->chunks, d->storedBytes / 1048576.0);
+
+	for (int i = 0; i < d->emptyCount; i++)
+		destroyDatasetBuffer(d->empty[i]);
+	fclose(d->f);
+	pthread_mutex_destroy(&d->lock);
+	pthread_cond_destroy(&d->changed);
+	free(d);
+}
+
+/**
+ * @brief This function maps a dataset file for reading
+ * @param r - the reader
+ * @param filePath - the dataset file
+ * @return 1 if all went well, 0 if the file could not be mapped or is not a dataset
+ */
+int openDatasetReader(datasetReader* r, const char* filePath) {
+	memset(r, 0, sizeof(datasetReader));
+	int fd = open(filePath, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(datasetFileHeader)) {
+		if (fd >= 0)
+			close(fd);
+		return 0;
+	}
+
+	void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	datasetFileHeader header;
+	memcpy(&header, map, sizeof(header));
+	if (header.magic != DATASET_MAGIC || header.features != DATASET_FEATURES) {
+		munmap(map, info.st_size);
+		return 0;
+	}
+
+	r->map = map;
+	r->size = info.st_size;
+	r->offset = sizeof(datasetFileHeader);
+	return 1;
+}
+
+/**
+ * @brief This function gets the columns of the next chunk. Uncompressed columns point straight
+ * 		  into the mapping, compressed ones into a buffer that is reused by the next call.
+ * @param r - the reader
+ * @param chunk - where the column pointers are stored
+ * @return 1 if there was another chunk, 0 at the end of the file or on a bad chunk
+ */
+int nextDatasetChunk(datasetReader* r, datasetChunk* chunk) {
+	datasetChunkHeader header;
+	if (r->offset + sizeof(header) > r->size)
+		return 0;
+
+	memcpy(&header, r->map + r->offset, sizeof(header));
+	const uint8_t* data = r->map + r->offset + sizeof(header);
+	if (header.magic != DATASET_CHUNK_MAGIC || header.storedSize > r->size - r->offset - sizeof(header) ||
+			header.rawSize != (size_t)header.rows * (DATASET_FEATURES * sizeof(float) + sizeof(int32_t) + 2))
+		return 0;
+
+	if (header.compressed) {
+#ifdef DATASET_ZLIB
+		if (header.rawSize > r->decompressedSize) {
+			r->decompressedSize = header.rawSize;
+			r->decompressed = realloc(r->decompressed, r->decompressedSize);
+		}
+		uLongf rawSize = header.rawSize;
+		if (uncompress(r->decompressed, &rawSize, data, header.storedSize) != Z_OK || rawSize != header.rawSize)
+			return 0;
+		data = r->decompressed;
+#else
+		printf("Built without DATASET_ZLIB, compressed chunks can't be read\n");
+		return 0;
+#endif
+	}
+
+	chunk->rows = header.rows;
+	for (int i = 0; i < DATASET_FEATURES; i++)
+		chunk->features[i] = (const float*)(data + (size_t)i * header.rows * sizeof(float));
+	chunk->scores = (const int32_t*)(data + (size_t)DATASET_FEATURES * header.rows * sizeof(float));
+	chunk->moves = (const uint8_t*)(chunk->scores + header.rows);
+	chunk->died = chunk->moves + header.rows;
+
+	r->offset += sizeof(header) + header.storedSize;
+	return 1;
+}
+
+/**
+ * @brief This function unmaps a dataset file
+ * @param r - the reader
+ * @return nothing
+ */
+void closeDatasetReader(datasetReader* r) {
+	munmap((void*)r->map, r->size);
+	free(r->decompressed);
+	memset(r, 0, sizeof(datasetReader));
+}
+
+/**
+ * @brief This function prints the size, move split and outcomes of a dataset
+ * @param filePath - the dataset file
+ * @return 1 if all went well, 0 if the file could not be read
+ */
+int summariseDataset(const char* filePath) {
+	datasetReader r;
+	datasetChunk chunk;
+	if (!openDatasetReader(&r, filePath)) {
+		printf("%s is not a dataset\n", filePath);
+		return 0;
+	}
+
+	long long rows = 0;
+	long long moves[3] = {0};
+	long long died = 0;
+	double scores = 0;
+	int chunks = 0;
+
+	while (nextDatasetChunk(&r, &chunk)) {
+		for (int i = 0; i < chunk.rows; i++) {
+			moves[chunk.moves[i] < 3 ? chunk.moves[i] : 1]++;
+			died += chunk.died[i];
+			scores += chunk.scores[i];
+		}
+		rows += chunk.rows;
+		chunks++;
+	}
+
+	printf("%lld ticks in %d chunks\n", rows, chunks);
+	if (rows) {
+		printf("Moves: %.1lf%% left, %.1lf%% forward, %.1lf%% right\n",
+			100.0 * moves[0] / rows, 100.0 * moves[1] / rows, 100.0 * moves[2] / rows);
+		printf("Mean final score %.2lf, %.1lf%% of ticks from games that ended in a collision\n",
+			scores / rows, 100.0 * died / rows);
+	}
+
+	closeDatasetReader(&r);
+	return 1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "snakeGame.h"
+
+#define DATASET_MAGIC 0x444b4e53		//"SNKD"
+#define DATASET_CHUNK_MAGIC 0x4b4e4843	//"CHNK"
+#define DATASET_FEATURES 16				//the inputs getInputs produces
+#define DATASET_CHUNK_ROWS 65536		//rows collected before a chunk is handed to the writer
+#define DATASET_BUFFERS 4				//chunks that can be filling or waiting to be written at once
+
+/*
+	A dataset file is a datasetFileHeader followed by chunks. Each chunk is a datasetChunkHeader
+	and then its columns, one after the other:
+		DATASET_FEATURES float32 columns, the inputs of each sampled tick
+		int32 score, the final score of the game the tick came from
+		uint8 move, 0 left, 1 forward, 2 right
+		uint8 died, 1 if that game ended in a collision, 0 if the snake starved
+	padded to 8 bytes. If the chunk is compressed (zlib, only when built with DATASET_ZLIB) the
+	columns are stored as one deflate stream of rawSize bytes.
+*/
+struct datasetFileHeader {
+	uint32_t magic;
+	uint32_t features;
+};
+typedef struct datasetFileHeader datasetFileHeader;
+
+struct datasetChunkHeader {
+	uint32_t magic;
+	uint32_t rows;
+	uint32_t compressed;
+	uint32_t rawSize;			//bytes of the columns
+	uint64_t storedSize;		//bytes that follow this header, including padding
+};
+typedef struct datasetChunkHeader datasetChunkHeader;
+
+struct datasetBuffer {
+	float* features;			//row major while recording, the writer makes it columnar
+	int32_t* scores;
+	uint8_t* moves;
+	uint8_t* died;
+	int rows;
+	int capacity;
+};
+typedef struct datasetBuffer datasetBuffer;
+
+struct datasetRecorder {
+	FILE* f;
+	int compress;
+	uint64_t threshold;			//a tick is recorded if the top 32 bits of the next random number are below this
+	uint64_t random;
+	datasetBuffer* current;
+	int gameStart;				//the first row of the game being played, its outcome isn't known yet
+
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	datasetBuffer* full[DATASET_BUFFERS];
+	int fullCount;
+	datasetBuffer* empty[DATASET_BUFFERS];
+	int emptyCount;
+	int closing;
+
+	long long rows;
+	long long chunks;
+	long long storedBytes;
+};
+typedef struct datasetRecorder datasetRecorder;
+
+struct datasetReader {
+	const uint8_t* map;
+	size_t size;
+	size_t offset;
+	void* decompressed;
+	size_t decompressedSize;
+};
+typedef struct datasetReader datasetReader;
+
+struct datasetChunk {
+	int rows;
+	const float* features[DATASET_FEATURES];
+	const int32_t* scores;
+	const uint8_t* moves;
+	const uint8_t* died;
+};
+typedef struct datasetChunk datasetChunk;
+
+datasetRecorder* openDataset(const char*, double, int);
+void recordDatasetTick(datasetRecorder*, const double*, int);
+void finishDatasetGame(datasetRecorder*, snake*);
+void closeDataset(datasetRecorder*);
+
+int openDatasetReader(datasetReader*, const char*);
+int nextDatasetChunk(datasetReader*, datasetChunk*);
+void closeDatasetReader(datasetReader*);
+int summariseDataset(const char*);
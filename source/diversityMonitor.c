@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "diversityMonitor.h"
+#include "neuralNetworkShell.h"
+
+/**
+ * @brief This function creates a diversity monitor for networks with a given layout
+ * @param nn - any network with the populations layout
+ * @param logPath - if not NULL, every generation is also written to this csv file
+ * @return the monitor, or NULL if the log could not be created
+ */
+diversityMonitor* openDiversityMonitor(neuralNetwork* nn, const char* logPath) {
+	FILE* log = NULL;
+	if (logPath && (log = fopen(logPath, "w")) == NULL) {
+		printf("Could not create %s\n", logPath);
+		return NULL;
+	}
+	if (log)
+		fprintf(log, "generation,spread,clusters,elite\n");
+
+	diversityMonitor* d = calloc(1, sizeof(diversityMonitor));
+	d->log = log;
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		d->parameters += nn->networkLayout[i] * nn->networkLayout[i+1] + nn->networkLayout[i+1];
+
+	size_t projectionSize = (size_t)d->parameters * DIVERSITY_SKETCH * sizeof(float);
+	if (posix_memalign((void**)&d->projection, 16, projectionSize) != 0) {
+		if (log)
+			fclose(log);
+		free(d);
+		return NULL;
+	}
+
+	unsigned int seed = DIVERSITY_SEED;
+	float scale = 1 / sqrtf(DIVERSITY_SKETCH);
+	for (size_t i = 0; i < (size_t)d->parameters * DIVERSITY_SKETCH; i++)
+		d->projection[i] = rand_r(&seed) & 1 ? scale : -scale;
+
+	d->genome = malloc(d->parameters * sizeof(float));
+	return d;
+}
+
+/**
+ * @brief This function copies a genome out of a network into one flat row of floats, in the
+ * 		  same order mate splices them, weights then biases
+ * @param nn - the network
+ * @param genome - where the genome is written
+ * @return nothing
+ */
+static void flattenGenome(neuralNetwork* nn, float* genome) {
+	int p = 0;
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i]; j++)
+			for (int k = 0; k < nn->networkLayout[i+1]; k++)
+				genome[p++] = nn->weights[i][j][k];
+
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i+1]; j++)
+			genome[p++] = nn->biases[i][j];
+}
+
+/**
+ * @brief This function projects a genome onto its sketch, the whole sketch is kept in registers
+ * 		  while the genome is gone through
+ * @param genome - the flattened genome
+ * @param projection - parameters rows of DIVERSITY_SKETCH, 16 byte aligned
+ * @param parameters - the length of the genome
+ * @param sketch - where the sketch is written
+ * @return nothing
+ */
+static void projectGenome(const float* genome, const float* projection, int parameters, float* sketch) {
+#ifdef __SSE2__
+	__m128 sum[DIVERSITY_SKETCH / 4];
+	for (int l = 0; l < DIVERSITY_SKETCH / 4; l++)
+		sum[l] = _mm_setzero_ps();
+
+	for (int p = 0; p < parameters; p++) {
+		__m128 x = _mm_set1_ps(genome[p]);
+		const float* row = projection + (size_t)p * DIVERSITY_SKETCH;
+		for (int l = 0; l < DIVERSITY_SKETCH / 4; l++)
+			sum[l] = _mm_add_ps(sum[l], _mm_mul_ps(x, _mm_load_ps(row + l * 4)));
+	}
+
+	for (int l = 0; l < DIVERSITY_SKETCH / 4; l++)
+		_mm_storeu_ps(sketch + l * 4, sum[l]);
+#else
+	for (int l = 0; l < DIVERSITY_SKETCH; l++)
+		sketch[l] = 0;
+	for (int p = 0; p < parameters; p++)
+		for (int l = 0; l < DIVERSITY_SKETCH; l++)
+			sketch[l] += genome[p] * projection[(size_t)p * DIVERSITY_SKETCH + l];
+#endif
+}
+
+/**
+ * @brief This function works out the squared distance between two sketches
+ * @param a - a sketch
+ * @param b - another sketch
+ * @return the squared distance
+ */
+static double sketchDistance(const float* a, const float* b) {
+	double distance = 0;
+	for (int l = 0; l < DIVERSITY_SKETCH; l++)
+		distance += (a[l] - b[l]) * (a[l] - b[l]);
+	return distance;
+}
+
+/**
+ * @brief This function sketches every genome in a population and estimates how diverse it is. Each
+ * 		  genome is compared with the mean and with at most DIVERSITY_MAX_CLUSTERS cluster leaders,
+ * 		  never with every other genome.
+ * @param d - the monitor
+ * @param population - the networks, all with the layout the monitor was opened with
+ * @param count - the number of networks
+ * @param elite - the index of the best network
+ * @param stats - where the estimates are stored
+ * @return nothing
+ */
+void measureDiversity(diversityMonitor* d, neuralNetwork** population, int count, int elite, diversityStats* stats) {
+	if (count > d->capacity) {
+		d->capacity = count;
+		d->sketches = realloc(d->sketches, (size_t)count * DIVERSITY_SKETCH * sizeof(float));
+	}
+
+	double mean[DIVERSITY_SKETCH] = {0};
+	for (int i = 0; i < count; i++) {
+		float* sketch = &d->sketches[(size_t)i * DIVERSITY_SKETCH];
+		flattenGenome(population[i], d->genome);
+		projectGenome(d->genome, d->projection, d->parameters, sketch);
+		for (int l = 0; l < DIVERSITY_SKETCH; l++)
+			mean[l] += sketch[l];
+	}
+
+	float centre[DIVERSITY_SKETCH];
+	for (int l = 0; l < DIVERSITY_SKETCH; l++)
+		centre[l] = mean[l] / count;
+
+	//the mean squared distance from the mean is half the mean squared distance between every pair
+	double squares = 0;
+	for (int i = 0; i < count; i++)
+		squares += sketchDistance(&d->sketches[(size_t)i * DIVERSITY_SKETCH], centre);
+	stats->spread = sqrt(squares / count);
+	stats->eliteDistance = sqrt(sketchDistance(&d->sketches[(size_t)elite * DIVERSITY_SKETCH], centre));
+
+	//the radius is fixed by the random first generation, so a collapsing population shows up as fewer clusters
+	if (d->clusterRadius == 0)
+		d->clusterRadius = stats->spread > 0 ? stats->spread * DIVERSITY_CLUSTER_RADIUS : 1e-9;
+
+	//each genome joins the first leader close enough, otherwise it leads a new cluster
+	int leaders[DIVERSITY_MAX_CLUSTERS];
+	double radius = d->clusterRadius * d->clusterRadius;
+	stats->clusters = 0;
+	for (int i = 0; i < count; i++) {
+		float* sketch = &d->sketches[(size_t)i * DIVERSITY_SKETCH];
+		int joined = 0;
+		for (int c = 0; c < stats->clusters && !joined; c++)
+			joined = sketchDistance(sketch, &d->sketches[(size_t)leaders[c] * DIVERSITY_SKETCH]) <= radius;
+
+		if (!joined && stats->clusters < DIVERSITY_MAX_CLUSTERS)
+			leaders[stats->clusters++] = i;
+	}
+}
+
+/**
+ * @brief This function prints a generations diversity, and writes it to the log if there is one
+ * @param d - the monitor
+ * @param generation - the generation
+ * @param stats - the generations diversity
+ * @return nothing
+ */
+void logDiversity(diversityMonitor* d, int generation, diversityStats* stats) {
+	printf("Diversity for Generation%d: spread %lf, %s%d clusters, elite %lf from the mean\n", generation, stats->spread,
+		stats->clusters == DIVERSITY_MAX_CLUSTERS ? "at least " : "", stats->clusters, stats->eliteDistance);
+
+	if (d->log) {
+		fprintf(d->log, "%d,%lf,%d,%lf\n", generation, stats->spread, stats->clusters, stats->eliteDistance);
+		fflush(d->log);
+	}
+}
+
+/**
+ * @brief This function frees a diversity monitor and closes its log
+ * @param d - the monitor
+ * @return nothing
+ */
+void closeDiversityMonitor(diversityMonitor* d) {
+	if (d->log)
+		fclose(d->log);
+	free(d->projection);
+	free(d->genome);
+	free(d->sketches);
+	free(d);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdio.h>
+
+#include "neuralNetworkShell.h"
+
+#define DIVERSITY_SKETCH 16				//floats in each genomes sketch, a multiple of 4 for SSE2
+#define DIVERSITY_MAX_CLUSTERS 256		//clusters counted, past this the count is a lower bound
+#define DIVERSITY_CLUSTER_RADIUS 0.25	//genomes closer than this fraction of the first generations spread share a cluster
+#define DIVERSITY_SEED 0x5eed			//the projection is the same every run, so runs can be compared
+
+/*
+	Every genome, its weights then its biases, is multiplied by the same random DIVERSITY_SKETCH
+	column matrix of +-1/sqrt(DIVERSITY_SKETCH). Distances between sketches are close to the
+	distances between the genomes, so the population can be measured in DIVERSITY_SKETCH
+	dimensions instead of one per weight, and without comparing every pair:
+		spread - the rms distance of the genomes from the population mean
+		clusters - groups of genomes within the cluster radius of each other
+		elite - the distance of the best genome from the population mean
+*/
+struct diversityMonitor {
+	int parameters;						//weights and biases in each genome
+	float* projection;					//parameters rows of DIVERSITY_SKETCH, 16 byte aligned
+	float* genome;						//scratch, one genome flattened to floats
+	float* sketches;					//DIVERSITY_SKETCH per genome
+	int capacity;						//genomes there is room for
+	double clusterRadius;				//0 until the first generation is measured
+	FILE* log;							//if not NULL, every generation is written here as csv
+};
+typedef struct diversityMonitor diversityMonitor;
+
+struct diversityStats {
+	double spread;
+	int clusters;
+	double eliteDistance;
+};
+typedef struct diversityStats diversityStats;
+
+diversityMonitor* openDiversityMonitor(neuralNetwork*, const char*);
+void measureDiversity(diversityMonitor*, neuralNetwork**, int, int, diversityStats*);
+void logDiversity(diversityMonitor*, int, diversityStats*);
+void closeDiversityMonitor(diversityMonitor*);
@@ -0,0 +1,280 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "evolutionStrategies.h"
+#include "neuralNetworkShell.h"
+#include "geneticNeuralNetwork.h"
+#include "snakeGame.h"
+#include "replay.h"
+#include "main.h"
+
+struct rankedReturn {
+	double fitness;
+	int index;
+};
+typedef struct rankedReturn rankedReturn;
+
+/**
+ * @brief This function compares two returns by their fitness, for qsort
+ * @param a - a rankedReturn
+ * @param b - another rankedReturn
+ * @return -1, 0 or 1 as a is less than, equal to or greater than b
+ */
+static int compareReturns(const void* a, const void* b) {
+	double x = ((const rankedReturn*)a)->fitness;
+	double y = ((const rankedReturn*)b)->fitness;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief This function fills the shared noise table with gaussian noise, from the same seed every run
+ * @param noise - ES_NOISE_TABLE floats
+ * @return nothing
+ */
+static void fillNoiseTable(float* noise) {
+	unsigned int seed = ES_NOISE_SEED;
+	for (int i = 0; i < ES_NOISE_TABLE; i += 2) {
+		//box muller, the + 1 keeps log away from 0
+		double u = (rand_r(&seed) + 1.0) / (RAND_MAX + 1.0);
+		double v = rand_r(&seed) / (RAND_MAX + 1.0);
+		double r = sqrt(-2 * log(u));
+		noise[i] = r * cos(2 * M_PI * v);
+		noise[i+1] = r * sin(2 * M_PI * v);
+	}
+}
+
+/**
+ * @brief This function writes a genome plus some noise into a network, weights then biases
+ * @param nn - the network
+ * @param centre - the genome
+ * @param noise - one float per parameter, or NULL for none
+ * @param scale - what the noise is multiplied by
+ * @return nothing
+ */
+static void setGenome(neuralNetwork* nn, const double* centre, const float* noise, double scale) {
+	int p = 0;
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i]; j++)
+			for (int k = 0; k < nn->networkLayout[i+1]; k++, p++)
+				nn->weights[i][j][k] = centre[p] + (noise ? scale * noise[p] : 0);
+
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i+1]; j++, p++)
+			nn->biases[i][j] = centre[p] + (noise ? scale * noise[p] : 0);
+}
+
+/**
+ * @brief This function copies a networks genome out, weights then biases
+ * @param nn - the network
+ * @param centre - where the genome is written
+ * @return nothing
+ */
+static void getGenome(neuralNetwork* nn, double* centre) {
+	int p = 0;
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i]; j++)
+			for (int k = 0; k < nn->networkLayout[i+1]; k++)
+				centre[p++] = nn->weights[i][j][k];
+
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i+1]; j++)
+			centre[p++] = nn->biases[i][j];
+}
+
+/**
+ * @brief This function scores one side of a pair, on the games that start from the pairs seed,
+ * 		  with the same fitness getFitness gives
+ * @param nn - the network, with the sides genome set
+ * @param seed - the seed of the first game, each game after uses the next seed
+ * @param outcomes - if not NULL, the games are stored in this log
+ * @param individual - the sides row in the outcome log
+ * @return the fitness of the side
+ */
+static double scoreSide(neuralNetwork* nn, unsigned int seed, outcomeLog* outcomes, int individual) {
+	snake s;
+	board b;
+	double fitness = 0;
+
+	for (int g = 0; g < FITNESS_GAMES; g++) {
+		b.seed = seed + g;
+		playCompTrain(nn, &s, &b, NULL, NULL);
+		fitness += gameFitness(&s, FITNESS_EXPONENTIAL);
+		if (outcomes)
+			recordOutcome(outcomes, individual, g, &s);
+		free(s.x);
+		free(s.y);
+	}
+
+	if (outcomes)
+		recordIndividualFitness(outcomes, individual, fitness / FITNESS_GAMES);
+	return fitness / FITNESS_GAMES;
+}
+
+/**
+ * @brief This function scores pairs until there are none left, each worker has its own network
+ * 		  and only reads the centre and noise
+ * @param arg - the esState
+ * @return NULL
+ */
+static void* esWorker(void* arg) {
+	esState* es = arg;
+	neuralNetwork nn = {0};
+	initialiseNetworkBrain(&nn);
+
+	int pair;
+	while ((pair = atomic_fetch_add(&es->nextPair, 1)) < es->pairs) {
+		const float* noise = &es->noise[es->offsets[pair]];
+		setGenome(&nn, es->centre, noise, ES_SIGMA);
+		es->returns[2 * pair] = scoreSide(&nn, es->seeds[pair], es->outcomes, 2 * pair);
+		setGenome(&nn, es->centre, noise, -ES_SIGMA);
+		es->returns[2 * pair + 1] = scoreSide(&nn, es->seeds[pair], es->outcomes, 2 * pair + 1);
+	}
+
+	destroyBrainData(&nn);
+	return NULL;
+}
+
+/**
+ * @brief This function moves the centre towards the better side of each pair. Fitnesses are
+ * 		  replaced by their rank, from -0.5 to 0.5, so a few huge fitnesses can't swamp the step.
+ * @param es - the state, every pair scored
+ * @param ranked - scratch for two returns per pair
+ * @param gradient - scratch for one double per parameter
+ * @return nothing
+ */
+static void updateCentre(esState* es, rankedReturn* ranked, double* gradient) {
+	int count = 2 * es->pairs;
+	for (int i = 0; i < count; i++) {
+		ranked[i].fitness = es->returns[i];
+		ranked[i].index = i;
+	}
+	qsort(ranked, count, sizeof(rankedReturn), compareReturns);
+	for (int i = 0; i < count; i++)
+		es->returns[ranked[i].index] = (double)i / (count - 1) - 0.5;
+
+	memset(gradient, 0, es->parameters * sizeof(double));
+	for (int i = 0; i < es->pairs; i++) {
+		double weight = es->returns[2 * i] - es->returns[2 * i + 1];
+		const float* noise = &es->noise[es->offsets[i]];
+		for (int p = 0; p < es->parameters; p++)
+			gradient[p] += weight * noise[p];
+	}
+
+	for (int p = 0; p < es->parameters; p++)
+		es->centre[p] += ES_LEARNING_RATE * (gradient[p] / (count * ES_SIGMA) - ES_WEIGHT_DECAY * es->centre[p]);
+}
+
+/**
+ * @brief This function trains a network with evolution strategies instead of the genetic
+ * 		  algorithm, see evolutionStrategies.h. Each generations centre is saved and plays one
+ * 		  recorded game, like the best brain of a genetic generation.
+ * @param generations - the number of generations
+ * @param options - esPairs, threads and the outcome log are used, and the target score is reported
+ * @return 1 if it trained, 0 if the layout has too many parameters
+ */
+int trainEvolutionStrategies(int generations, trainingOptions* options) {
+	neuralNetwork nn = {0};
+	initialiseNetworkBrain(&nn);
+	randomiseNetwork(&nn);
+
+	esState es;
+	es.parameters = 0;
+	for (int i = 0; i < nn.networkSize - 1; i++)
+		es.parameters += nn.networkLayout[i] * nn.networkLayout[i+1] + nn.networkLayout[i+1];
+
+	//every perturbation is a slice of the noise table, so the genome must fit inside it
+	if (es.parameters >= ES_NOISE_TABLE) {
+		printf("Evolution strategies needs fewer than %d parameters, this layout has %d\n", ES_NOISE_TABLE, es.parameters);
+		destroyBrainData(&nn);
+		return 0;
+	}
+	es.pairs = options->esPairs;
+	es.noise = malloc(ES_NOISE_TABLE * sizeof(float));
+	es.centre = malloc(es.parameters * sizeof(double));
+	es.offsets = malloc(es.pairs * sizeof(unsigned int));
+	es.seeds = malloc(es.pairs * sizeof(unsigned int));
+	es.returns = malloc(2 * es.pairs * sizeof(double));
+	es.outcomes = NULL;
+	if (options->outcomeLogPath)
+		es.outcomes = openOutcomeLog(options->outcomeLogPath, 2 * es.pairs, FITNESS_GAMES);
+	fillNoiseTable(es.noise);
+	getGenome(&nn, es.centre);
+
+	rankedReturn* ranked = malloc(2 * es.pairs * sizeof(rankedReturn));
+	double* gradient = malloc(es.parameters * sizeof(double));
+	int threads = options->threads > 0 ? options->threads : sysconf(_SC_NPROCESSORS_ONLN);
+	pthread_t* workers = calloc(threads, sizeof(pthread_t));
+	printf("Evolution strategies with %d pairs of %d parameters on %d threads\n", es.pairs, es.parameters, threads);
+
+	snake* s = malloc(sizeof(snake));
+	board* b = malloc(sizeof(board));
+	replay* best = malloc(sizeof(replay));
+	initialiseReplay(best);
+
+	struct timespec start, now;
+	int reachedTarget = 0;
+	long games = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (int i = 0; i < generations; i++) {
+		for (int j = 0; j < es.pairs; j++) {
+			es.offsets[j] = rand() % (ES_NOISE_TABLE - es.parameters);
+			es.seeds[j] = rand();
+		}
+		atomic_store(&es.nextPair, 0);
+		for (int j = 0; j < threads; j++)
+			pthread_create(&workers[j], NULL, esWorker, &es);
+		for (int j = 0; j < threads; j++)
+			pthread_join(workers[j], NULL);
+		games += 2L * FITNESS_GAMES * es.pairs + 1;
+		if (es.outcomes)
+			writeOutcomeGeneration(es.outcomes, i+1);
+
+		double averageFitness = 0;
+		for (int j = 0; j < 2 * es.pairs; j++)
+			averageFitness += es.returns[j];
+		printf("Average fitness for Generation%d: %lf\n", i+1, averageFitness / (2 * es.pairs));
+		updateCentre(&es, ranked, gradient);
+
+		char temp[4096];
+		setGenome(&nn, es.centre, NULL, 0);
+		sprintf(temp, "brains/Generation_%d", i+1);
+		saveBrain(&nn, temp);
+
+		best->header.generation = i+1;
+		b->seed = rand();
+		playCompTrain(&nn, s, b, best, NULL);
+		appendReplay(best, "brains/replays");
+		free(s->x);
+		free(s->y);
+
+		if (options->targetScore && !reachedTarget && best->header.score >= options->targetScore) {
+			reachedTarget = 1;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			printf("Generation%d reached the target score of %d after %.1lf seconds and %ld games\n", i+1, options->targetScore,
+				(now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9, games);
+		}
+	}
+
+	if (es.outcomes)
+		closeOutcomeLog(es.outcomes);
+	destroyReplay(best);
+	free(best);
+	free(s);
+	free(b);
+	free(workers);
+	free(gradient);
+	free(ranked);
+	free(es.noise);
+	free(es.centre);
+	free(es.offsets);
+	free(es.seeds);
+	free(es.returns);
+	destroyBrainData(&nn);
+	return 1;
+}
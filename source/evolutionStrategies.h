@@ -0,0 +1,35 @@
+#pragma once
+#include <stdatomic.h>
+
+#include "geneticNeuralNetwork.h"
+
+#define ES_PAIRS 500					//antithetic pairs tried each generation, when --es is given no value
+#define ES_SIGMA 0.5					//the standard deviation of the noise added to the centre
+#define ES_LEARNING_RATE 0.3
+#define ES_WEIGHT_DECAY 0.005
+#define ES_NOISE_TABLE (1 << 22)		//floats in the shared noise table, 16MB
+#define ES_NOISE_SEED 0xe5				//the table is the same in every process
+
+/*
+	Instead of a population there is one centre genome, its weights then its biases. Every
+	generation each pair picks an offset into a table of gaussian noise shared by everyone, and
+	the centre plus and minus ES_SIGMA times the noise from that offset are scored on the same
+	FITNESS_GAMES seeded games, so the difference between the sides comes from the noise alone.
+	The centre then moves towards the noise whose plus side ranked better than its minus side.
+	A worker only needs the offset to rebuild a perturbation and only hands back two fitnesses,
+	so pairs can be spread over threads, or processes sharing the seed, without copying weights.
+*/
+struct esState {
+	int parameters;						//weights and biases in the genome
+	float* noise;						//ES_NOISE_TABLE gaussian floats
+	double* centre;
+	int pairs;
+	unsigned int* offsets;				//where each pairs noise starts in the table
+	unsigned int* seeds;				//the first game seed of each pair, both sides play the same games
+	double* returns;					//each pairs fitness with the noise added, then taken away
+	atomic_int nextPair;				//the next pair a worker takes
+	outcomeLog* outcomes;				//if not NULL, each pairs games are rows 2 * pair and 2 * pair + 1
+};
+typedef struct esState esState;
+
+int trainEvolutionStrategies(int, trainingOptions*);
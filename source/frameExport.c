@@ -0,0 +1,317 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#ifdef FRAME_EXPORT_PNG
+#include <png.h>
+#endif
+
+#include "frameExport.h"
+#include "snakeGame.h"
+#include "replay.h"
+
+/**
+ * @brief This function fills a rectangle of an rgba image with one colour
+ * @param pixels - the image
+ * @param stride - bytes per row of the image
+ * @param x - the left of the rectangle
+ * @param y - the top of the rectangle
+ * @param w - the width of the rectangle
+ * @param h - the height of the rectangle
+ * @param colour - the r, g, b and a bytes
+ * @return nothing
+ */
+static void fillPixels(uint8_t* pixels, int stride, int x, int y, int w, int h, const uint8_t colour[4]) {
+	uint8_t* row = pixels + (size_t)y * stride + (size_t)x * 4;
+	for (int i = 0; i < w; i++)
+		memcpy(row + i * 4, colour, 4);
+	for (int j = 1; j < h; j++)
+		memcpy(row + (size_t)j * stride, row, (size_t)w * 4);
+}
+
+/**
+ * @brief This function draws a board into an rgba image in memory, laid out the same way as
+ * 		  drawSnapshots lays out a tile, so it needs no renderer or window
+ * @param snap - the board
+ * @param pixels - the image, 4 bytes per pixel in r, g, b, a order
+ * @param width - the width of the image
+ * @param height - the height of the image
+ * @param stride - bytes per row of the image
+ * @return nothing
+ */
+void rasteriseSnapshot(const boardSnapshot* snap, uint8_t* pixels, int width, int height, int stride) {
+	static const uint8_t background[4] = {0, 0, 0, 255};
+	static const uint8_t snakeColour[4] = {255, 0, 0, 255};
+	static const uint8_t foodColour[4] = {0, 255, 0, 255};
+
+	fillPixels(pixels, stride, 0, 0, width, height, background);
+	if (snap->width <= 0 || snap->height <= 0)
+		return;
+
+	int cell = width / snap->width < height / snap->height ? width / snap->width : height / snap->height;
+	if (cell < 1)
+		return;
+	int gap = cell > 3;
+	int left = (width - cell * snap->width) / 2;
+	int top = (height - cell * snap->height) / 2;
+
+	if (snap->foodX >= 0 && snap->foodX < snap->width && snap->foodY >= 0 && snap->foodY < snap->height)
+		fillPixels(pixels, stride, left + snap->foodX*cell, top + snap->foodY*cell, cell - gap, cell - gap, foodColour);
+	for (int i = 0; i < snap->length; i++)
+		if (snap->x[i] < snap->width && snap->y[i] < snap->height)
+			fillPixels(pixels, stride, left + snap->x[i]*cell, top + snap->y[i]*cell, cell - gap, cell - gap, snakeColour);
+}
+
+/**
+ * @brief This function writes one frame of a game, as its own png or onto the end of a raw stream
+ * @param e - the exporter
+ * @param pixels - the frame
+ * @param width - the width of the frame
+ * @param height - the height of the frame
+ * @param raw - the raw stream, NULL for png
+ * @param name - the games name, the png directory
+ * @param tick - the frame number
+ * @return 1 if all went well, 0 if something went wrong
+ */
+static int writeFrame(frameExporter* e, uint8_t* pixels, int width, int height, FILE* raw, const char* name, int tick) {
+	if (raw)
+		return fwrite(pixels, (size_t)width * height * 4, 1, raw) == 1;
+
+#ifdef FRAME_EXPORT_PNG
+	char path[8192];
+	snprintf(path, sizeof(path), "%s/%s/%05d.png", e->directory, name, tick);
+
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	image.width = width;
+	image.height = height;
+	image.format = PNG_FORMAT_RGBA;
+	return png_image_write_to_file(&image, path, 0, pixels, width * 4, NULL) != 0;
+#else
+	//without libpng only raw streams can be written
+	(void)e;
+	(void)name;
+	(void)tick;
+	return 0;
+#endif
+}
+
+/**
+ * @brief This function replays a game from its seed, rasterising and writing every frame
+ * @param e - the exporter
+ * @param r - the game
+ * @param pixels - scratch space for one frame, grown as needed
+ * @param pixelsSize - the size of pixels
+ * @return 1 if all went well, 0 if something went wrong
+ */
+static int exportGame(frameExporter* e, replay* r, uint8_t** pixels, size_t* pixelsSize) {
+	char name[64];
+	char path[8192];
+	if (r->header.generation >= 0)
+		snprintf(name, sizeof(name), "Generation_%d", r->header.generation);
+	else
+		snprintf(name, sizeof(name), "Game_%d", e->exported);
+
+	snake s;
+	board b;
+	boardSnapshot* snap = malloc(sizeof(boardSnapshot));
+	seekReplay(r, &s, &b, 0);
+
+	int width = b.width * e->cellSize;
+	int height = b.height * e->cellSize;
+	if ((size_t)width * height * 4 > *pixelsSize) {
+		*pixelsSize = (size_t)width * height * 4;
+		*pixels = realloc(*pixels, *pixelsSize);
+	}
+
+	FILE* raw = NULL;
+	if (e->format == EXPORT_RAW) {
+		snprintf(path, sizeof(path), "%s/%s.rgba", e->directory, name);
+		raw = fopen(path, "wb");
+	} else {
+		snprintf(path, sizeof(path), "%s/%s", e->directory, name);
+		mkdir(path, 0755);
+	}
+
+	int written = e->format == EXPORT_PNG || raw;
+	for (int tick = 0; written; tick++) {
+		takeSnapshot(&s, &b, snap);
+		rasteriseSnapshot(snap, *pixels, width, height, width * 4);
+		written = writeFrame(e, *pixels, width, height, raw, name, tick);
+		if (tick == (int)r->header.ticks)
+			break;
+
+		s.move = getReplayMove(r, tick);
+		updateSnake(&s, &b);
+	}
+
+	if (!written)
+		printf("Could not export %s to %s\n", name, e->directory);
+	if (raw)
+		fclose(raw);
+	free(snap);
+	free(s.x);
+	free(s.y);
+	return written;
+}
+
+/**
+ * @brief This function is the export thread, it encodes games in the order they were queued
+ * @param arg - the exporter
+ * @return nothing
+ */
+static void* frameExportThread(void* arg) {
+	frameExporter* e = arg;
+	uint8_t* pixels = NULL;
+	size_t pixelsSize = 0;
+
+	pthread_mutex_lock(&e->lock);
+	while (1) {
+		while (!e->queueCount && !e->closing)
+			pthread_cond_wait(&e->changed, &e->lock);
+		if (!e->queueCount)
+			break;
+
+		//the game stays in the queue while it is encoded, so its slot isn't reused under it
+		replay* r = &e->queue[e->queueStart];
+		pthread_mutex_unlock(&e->lock);
+
+		e->exported += exportGame(e, r, &pixels, &pixelsSize);
+
+		pthread_mutex_lock(&e->lock);
+		e->queueStart = (e->queueStart + 1) % EXPORT_QUEUE;
+		e->queueCount--;
+		pthread_cond_broadcast(&e->changed);
+	}
+	pthread_mutex_unlock(&e->lock);
+
+	free(pixels);
+	return NULL;
+}
+
+/**
+ * @brief This function creates the export directory and starts the export thread
+ * @param directory - where the frames are written, created if needed
+ * @param format - EXPORT_PNG or EXPORT_RAW
+ * @param cellSize - pixels per board cell
+ * @return the exporter, or NULL if the directory could not be created
+ */
+frameExporter* openFrameExporter(const char* directory, exportFormat format, int cellSize) {
+	if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+		printf("Could not create %s\n", directory);
+		return NULL;
+	}
+
+#ifndef FRAME_EXPORT_PNG
+	if (format == EXPORT_PNG) {
+		printf("Built without FRAME_EXPORT_PNG, frames will be exported as raw rgba\n");
+		format = EXPORT_RAW;
+	}
+#endif
+
+	frameExporter* e = calloc(1, sizeof(frameExporter));
+	snprintf(e->directory, sizeof(e->directory), "%s", directory);
+	e->format = format;
+	e->cellSize = cellSize > 0 ? cellSize : EXPORT_CELL_SIZE;
+	for (int i = 0; i < EXPORT_QUEUE; i++)
+		initialiseReplay(&e->queue[i]);
+
+	if (format == EXPORT_RAW)
+		printf("Exporting raw rgba frames, %d pixels per board cell, to %s\n", e->cellSize, directory);
+	else
+		printf("Exporting png frames to %s\n", directory);
+
+	pthread_mutex_init(&e->lock, NULL);
+	pthread_cond_init(&e->changed, NULL);
+	pthread_create(&e->thread, NULL, frameExportThread, e);
+	return e;
+}
+
+/**
+ * @brief This function queues a recorded game to be exported, only its seed and moves are copied
+ * @param e - the exporter
+ * @param r - the game
+ * @param wait - if 0 the game is dropped when the queue is full, otherwise this waits for room
+ * @return 1 if the game was queued, 0 if it was dropped
+ */
+int exportReplay(frameExporter* e, replay* r, int wait) {
+	size_t bytes = (r->header.ticks + REPLAY_MOVES_PER_BYTE - 1) / REPLAY_MOVES_PER_BYTE;
+
+	pthread_mutex_lock(&e->lock);
+	while (wait && e->queueCount == EXPORT_QUEUE)
+		pthread_cond_wait(&e->changed, &e->lock);
+	if (e->queueCount == EXPORT_QUEUE) {
+		e->dropped++;
+		pthread_mutex_unlock(&e->lock);
+		return 0;
+	}
+
+	replay* queued = &e->queue[(e->queueStart + e->queueCount) % EXPORT_QUEUE];
+	queued->header = r->header;
+	if (bytes > (size_t)queued->capacity) {
+		queued->capacity = bytes;
+		queued->moves = realloc(queued->moves, queued->capacity);
+	}
+	memcpy(queued->moves, r->moves, bytes);
+
+	e->queueCount++;
+	pthread_cond_broadcast(&e->changed);
+	pthread_mutex_unlock(&e->lock);
+	return 1;
+}
+
+/**
+ * @brief This function waits for the queued games to be exported and stops the export thread
+ * @param e - the exporter
+ * @return nothing
+ */
+void closeFrameExporter(frameExporter* e) {
+	pthread_mutex_lock(&e->lock);
+	e->closing = 1;
+	pthread_cond_broadcast(&e->changed);
+	pthread_mutex_unlock(&e->lock);
+
+	pthread_join(e->thread, NULL);
+	printf("Exported %d games to %s", e->exported, e->directory);
+	if (e->dropped)
+		printf(", %d dropped while the export queue was full", e->dropped);
+	printf("\n");
+
+	for (int i = 0; i < EXPORT_QUEUE; i++)
+		destroyReplay(&e->queue[i]);
+	pthread_mutex_destroy(&e->lock);
+	pthread_cond_destroy(&e->changed);
+	free(e);
+}
+
+/**
+ * @brief This function exports every game in a replay file
+ * @param filePath - the replay file
+ * @param directory - where the frames are written
+ * @param format - EXPORT_PNG or EXPORT_RAW
+ * @param cellSize - pixels per board cell
+ * @return 1 if all went well, 0 if the file has no replays or the directory could not be created
+ */
+int exportReplayFile(const char* filePath, const char* directory, exportFormat format, int cellSize) {
+	int count = countReplays(filePath);
+	if (!count) {
+		printf("%s is not a replay file\n", filePath);
+		return 0;
+	}
+
+	frameExporter* e = openFrameExporter(directory, format, cellSize);
+	if (e == NULL)
+		return 0;
+
+	replay r;
+	initialiseReplay(&r);
+	for (int i = 0; i < count && loadReplay(&r, filePath, i); i++)
+		exportReplay(e, &r, 1);
+
+	destroyReplay(&r);
+	closeFrameExporter(e);
+	return 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include <pthread.h>
+
+#include "snakeGame.h"
+#include "replay.h"
+
+#define EXPORT_QUEUE 8					//games waiting to be encoded, more are dropped rather than waiting
+#define EXPORT_CELL_SIZE 10				//pixels per board cell by default
+
+enum exportFormat {
+	EXPORT_PNG,							//directory/Generation_N/00000.png, ... only when built with FRAME_EXPORT_PNG
+	EXPORT_RAW							//directory/Generation_N.rgba, the frames back to back as raw rgba
+};
+typedef enum exportFormat exportFormat;
+
+/*
+	Renders recorded games without SDL or a display. The trainer only hands over the replay, which
+	is a seed and the moves, so the game is replayed, rasterised and encoded on the export thread.
+	The raw format can be turned into a video with
+		ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r 50 -i Generation_N.rgba Generation_N.mp4
+*/
+struct frameExporter {
+	char directory[4096];
+	exportFormat format;
+	int cellSize;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	replay queue[EXPORT_QUEUE];			//a ring, each with its own copy of the moves
+	int queueStart;
+	int queueCount;
+	int closing;
+
+	int exported;						//games written, only read once the thread has finished
+	int dropped;						//games that arrived while the queue was full
+};
+typedef struct frameExporter frameExporter;
+
+void rasteriseSnapshot(const boardSnapshot*, uint8_t*, int, int, int);
+frameExporter* openFrameExporter(const char*, exportFormat, int);
+int exportReplay(frameExporter*, replay*, int);
+void closeFrameExporter(frameExporter*);
+int exportReplayFile(const char*, const char*, exportFormat, int);
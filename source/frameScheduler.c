@@ -0,0 +1,168 @@
+#include <SDL2/SDL.h>
+
+#include "frameScheduler.h"
+
+/**
+ * @brief This function sets up a scheduler, the first tick is due straight away
+ * @param f - the scheduler
+ * @param ticksPerSecond - the game speed at a speed of 1
+ * @return nothing
+ */
+void initialiseFrameScheduler(frameScheduler* f, double ticksPerSecond) {
+	f->frequency = SDL_GetPerformanceFrequency();
+	f->lastUpdate = SDL_GetPerformanceCounter();
+	f->lastRender = f->lastUpdate - f->frequency;
+	f->statsStart = f->lastUpdate;
+	f->tickSeconds = 1.0 / ticksPerSecond;
+	f->pending = 1;
+	f->speed = 1;
+	f->unthrottled = 0;
+	f->paused = 0;
+	f->dirty = 1;
+	f->statsTicks = 0;
+	f->statsFrames = 0;
+	f->ticksPerSecond = 0;
+	f->framesPerSecond = 0;
+}
+
+/**
+ * @brief This function adds the ticks that have become due since it was last called
+ * @param f - the scheduler
+ * @return the current performance counter
+ */
+static Uint64 updatePending(frameScheduler* f) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (!f->paused && !f->unthrottled) {
+		f->pending += (double)(now - f->lastUpdate) / f->frequency / f->tickSeconds * f->speed;
+
+		//don't try to catch up after the window was dragged or the machine stalled
+		double limit = FRAME_MAX_SPEED * 4;
+		if (f->pending > limit)
+			f->pending = limit;
+	}
+	f->lastUpdate = now;
+	return now;
+}
+
+/**
+ * @brief This function waits for the next event, but no longer than until the next tick or render is due
+ * @param f - the scheduler
+ * @param e - where the event is stored
+ * @return 1 if there was an event, 0 if it is time to tick or render
+ */
+int waitForFrameEvent(frameScheduler* f, SDL_Event* e) {
+	Uint64 now = updatePending(f);
+	double wait = FRAME_IDLE_WAIT / 1000.0;
+
+	if (f->unthrottled && !f->paused)
+		wait = 0;
+	else if (!f->paused)
+		wait = (1 - f->pending) * f->tickSeconds / f->speed;
+
+	if (f->dirty) {
+		Uint64 renderDue = f->lastRender + f->frequency / FRAME_MAX_FPS;
+		double renderWait = renderDue > now ? (double)(renderDue - now) / f->frequency : 0;
+		if (renderWait < wait)
+			wait = renderWait;
+	}
+
+	int timeout = wait > 0 ? (int)(wait * 1000 + 0.999) : 0;
+	if (timeout <= 0)
+		return SDL_PollEvent(e);
+	return SDL_WaitEventTimeout(e, timeout);
+}
+
+/**
+ * @brief This function decides whether the game should be updated again before the next render
+ * @param f - the scheduler
+ * @return 1 if a tick is due, 0 otherwise
+ */
+int nextTick(frameScheduler* f) {
+	Uint64 now = updatePending(f);
+	if (f->paused)
+		return 0;
+
+	//unthrottled, tick until it is time to show the next frame
+	if (f->unthrottled) {
+		if (f->dirty && now - f->lastRender >= f->frequency / FRAME_MAX_FPS)
+			return 0;
+	} else if (f->pending >= 1) {
+		f->pending--;
+	} else {
+		return 0;
+	}
+
+	f->dirty = 1;
+	f->statsTicks++;
+	return 1;
+}
+
+/**
+ * @brief This function decides whether a frame should be drawn, only if something changed and the
+ * 		  frame rate cap allows it. Also keeps the measured tick and frame rates up to date.
+ * @param f - the scheduler
+ * @return 1 if the caller should render, 0 otherwise
+ */
+int nextRender(frameScheduler* f) {
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	if (now - f->statsStart >= f->frequency) {
+		double seconds = (double)(now - f->statsStart) / f->frequency;
+		f->ticksPerSecond = f->statsTicks / seconds;
+		f->framesPerSecond = f->statsFrames / seconds;
+		f->statsTicks = 0;
+		f->statsFrames = 0;
+		f->statsStart = now;
+	}
+
+	if (!f->dirty || now - f->lastRender < f->frequency / FRAME_MAX_FPS)
+		return 0;
+
+	f->dirty = 0;
+	f->lastRender = now;
+	f->statsFrames++;
+	return 1;
+}
+
+/**
+ * @brief This function scales the game speed, going past FRAME_MAX_SPEED makes it unthrottled
+ * @param f - the scheduler
+ * @param factor - what the speed is multiplied by
+ * @return nothing
+ */
+void changeFrameSpeed(frameScheduler* f, double factor) {
+	if (f->unthrottled) {
+		if (factor < 1)
+			f->unthrottled = 0;
+	} else {
+		f->speed *= factor;
+		if (f->speed > FRAME_MAX_SPEED) {
+			f->speed = FRAME_MAX_SPEED;
+			f->unthrottled = 1;
+		}
+		if (f->speed < FRAME_MIN_SPEED)
+			f->speed = FRAME_MIN_SPEED;
+	}
+	f->pending = 0;
+	f->dirty = 1;
+}
+
+/**
+ * @brief This function pauses or unpauses the game
+ * @param f - the scheduler
+ * @return nothing
+ */
+void toggleFramePause(frameScheduler* f) {
+	f->paused = !f->paused;
+	f->pending = 0;
+	f->dirty = 1;
+}
+
+/**
+ * @brief This function asks for a render even though the game hasn't ticked, e.g. after seeking
+ * @param f - the scheduler
+ * @return nothing
+ */
+void redrawFrame(frameScheduler* f) {
+	f->dirty = 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+#define FRAME_MAX_FPS 60			//renders are capped at this, however fast the game is ticking
+#define FRAME_MAX_SPEED 64.0		//speeding up past this runs unthrottled
+#define FRAME_MIN_SPEED (1.0/64)
+#define FRAME_IDLE_WAIT 1000		//longest wait in ms when nothing is due, so the stats still update
+
+/*
+	A fixed timestep scheduler. The game ticks at ticksPerSecond * speed whatever the render rate
+	is, and between ticks the thread sleeps in SDL_WaitEventTimeout instead of spinning. Use it as:
+
+		while (playing) {
+			while (waitForFrameEvent(&f, &e))
+				handle e
+			while (nextTick(&f))
+				update the game
+			if (nextRender(&f))
+				draw the game
+		}
+*/
+struct frameScheduler {
+	Uint64 frequency;
+	Uint64 lastUpdate;			//performance counter when pending was last topped up
+	Uint64 lastRender;
+	Uint64 statsStart;
+	double tickSeconds;			//seconds per tick at speed 1
+	double pending;				//ticks that are due, can be fractional
+	double speed;
+	int unthrottled;			//tick as fast as possible, rendering FRAME_MAX_FPS times a second
+	int paused;
+	int dirty;					//something changed since the last render
+	int statsTicks;
+	int statsFrames;
+	double ticksPerSecond;		//measured over the last second
+	double framesPerSecond;		//measured over the last second
+};
+typedef struct frameScheduler frameScheduler;
+
+void initialiseFrameScheduler(frameScheduler*, double);
+int waitForFrameEvent(frameScheduler*, SDL_Event*);
+int nextTick(frameScheduler*);
+int nextRender(frameScheduler*);
+void changeFrameSpeed(frameScheduler*, double);
+void toggleFramePause(frameScheduler*);
+void redrawFrame(frameScheduler*);
@@ -1,11 +1,39 @@
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
 
 #include "neuralNetworkShell.h"
 #include "geneticNeuralNetwork.h"
 #include "snakeGame.h"
+#include "replay.h"
 #include "main.h"
 
+/**
+ * @brief This function sets the training options to their defaults, nothing extra is recorded
+ * @param options - the options
+ * @return nothing
+ */
+void initialiseTrainingOptions(trainingOptions* options) {
+	options->datasetPath = NULL;
+	options->datasetSampleRate = 0.01;
+	options->datasetCompression = 0;
+	options->liveFeedName = NULL;
+	options->exportDirectory = NULL;
+	options->exportFormat = EXPORT_PNG;
+	options->exportCellSize = EXPORT_CELL_SIZE;
+	options->curriculum = NULL;
+	options->targetScore = 0;
+	options->diversity = 0;
+	options->diversityLog = NULL;
+	options->memeticInterval = 0;
+	options->esPairs = 0;
+	options->generations = TRAINING_GENERATIONS;
+	options->threads = 0;
+	options->outcomeLogPath = NULL;
+}
+
 /**
  * @brief This function allocates the memory for the training data that we need
  * @param population - the collection of networks in each population
@@ -47,42 +75,74 @@ void randomisePopulation(neuralNetwork** population) {
 /**
  * @brief This function gets the fitness score for an individual neural network.
  * @param nn - a pointer to the neural network
+ * @param dataset - if not NULL, the games are sampled into this dataset
+ * @param outcomes - if not NULL, how each game went is stored in this log
+ * @param individual - the networks row in the outcome log
  * @return the fitness of the network
  */
-long double getFitness(neuralNetwork* nn, int gen) {
+long double getFitness(neuralNetwork* nn, int gen, datasetRecorder* dataset, outcomeLog* outcomes, int individual) {
 	long double scores = 0;
 	snake* s = malloc(sizeof(snake));
 	board* b = malloc(sizeof(board));
 	initiliseSnakeAndBoard(s, b);
 
-	for (int i = 0; i < 3; i++) { 
-		playCompTrain(nn, s, b);
-		//scores = s->score;
-		scores += pow(2, s->score) * ((double)(s->time)/150);
-		//scores += s->score;
-		//scores += log10(((double)s->time) * pow(2, s->score));
+	for (int i = 0; i < FITNESS_GAMES; i++) { 
+		playCompTrain(nn, s, b, NULL, dataset);
+		scores += gameFitness(s, FITNESS_EXPONENTIAL);
+		if (outcomes)
+			recordOutcome(outcomes, individual, i, s);
 	}
 
 	free(s);
 	free(b);
-	return scores/3;
+	if (outcomes)
+		recordIndividualFitness(outcomes, individual, scores/FITNESS_GAMES);
+	return scores/FITNESS_GAMES;
+}
+
+/**
+ * @brief This function works out the fitness of one finished game
+ * @param s - the snake at the end of the game
+ * @param formula - how score and time are weighed
+ * @return the fitness of the game
+ */
+double gameFitness(snake* s, fitnessFormula formula) {
+	switch (formula) {
+	case FITNESS_SCORE:
+		return s->score;
+	case FITNESS_LOG:
+		return log10(((double)s->time) * pow(2, s->score));
+	default:
+		return pow(2, s->score) * ((double)(s->time)/150);
+	}
 }
 
 /**
  * @brief This function generates and stores the fitness of the entire population.
  * @param nn - the entire generation of neural networks
  * @param fitness - the fitness scores of the neural networks
+ * @param dataset - if not NULL, the games are sampled into this dataset
+ * @param outcomes - if not NULL, every individuals games are stored in this log
  * @return the average score of the whole generation
  */
-double getGenerationFitness(neuralNetwork** nn, double* fitness, int gen) {
+double getGenerationFitness(neuralNetwork** nn, double* fitness, int gen, datasetRecorder* dataset, outcomeLog* outcomes) {
 	long double averageScore = 0;
 	for (int i = 0; i < populationSize; i++) {
-        fitness[i] = getFitness(nn[i], gen);
+        fitness[i] = getFitness(nn[i], gen, dataset, outcomes, i);
 		averageScore += fitness[i];
 	}
 	return (averageScore/(double)populationSize);
 }
 
+/**
+ * @brief This function gets a random number, from the shared rand() or from the callers own seed
+ * @param seed - the seed to use with rand_r, or NULL for rand()
+ * @return a random number between 0 and RAND_MAX
+ */
+static int randomNumber(unsigned int* seed) {
+	return seed ? rand_r(seed) : rand();
+}
+
 /**
  * @brief This function creates a child by splicing the "genome" of 2 parents
  * @param parent1 - the first of the selected parents
@@ -91,12 +151,25 @@ double getGenerationFitness(neuralNetwork** nn, double* fitness, int gen) {
  * @return nothing
  */
 void mate(neuralNetwork* parent1, neuralNetwork* parent2, neuralNetwork* child) {
+	mateWith(parent1, parent2, child, NULL);
+}
+
+/**
+ * @brief This function creates a child like mate, with its own random numbers so it can be used
+ * 		  from several threads at once
+ * @param parent1 - the first of the selected parents
+ * @param parent2 - the other parent whos genes will be spliced
+ * @param child - the outputed network of this algorithm
+ * @param seed - the seed to use with rand_r, or NULL for rand()
+ * @return nothing
+ */
+void mateWith(neuralNetwork* parent1, neuralNetwork* parent2, neuralNetwork* child, unsigned int* seed) {
 	int totalNetworkDataPoints = 0;
 	for (int i = 0; i < parent1->networkSize-1; i++) 
 		totalNetworkDataPoints += (parent1->networkLayout[i] * parent1->networkLayout[i+1]) + parent1->networkLayout[i+1];
 
-    int splitPoint1 = rand()%totalNetworkDataPoints;
-    int splitPoint2 = rand()%(totalNetworkDataPoints - splitPoint1) + splitPoint1 + 1;
+    int splitPoint1 = randomNumber(seed)%totalNetworkDataPoints;
+    int splitPoint2 = randomNumber(seed)%(totalNetworkDataPoints - splitPoint1) + splitPoint1 + 1;
 
 	int currPoint = 0;
 	neuralNetwork* currentParent = parent1;
@@ -136,6 +209,29 @@ void mutate(neuralNetwork* nn, int generation) {
 	}
 }
 
+/**
+ * @brief This function mutates each weight and bias with a given chance, scaling it by 0.9 - 1.1
+ * @param nn - the neural network to mutate
+ * @param rate - the chance of each weight and bias being mutated, from 0 to 1
+ * @param seed - the seed to use with rand_r, or NULL for rand()
+ * @return nothing
+ */
+void mutateWith(neuralNetwork* nn, double rate, unsigned int* seed) {
+	for (int i = 0; i < nn->networkSize - 1; i++) {
+		for (int j = 0; j < nn->networkLayout[i+1]; j++) {
+			for (int k = 0; k < nn->networkLayout[i]; k++) {
+				if (randomNumber(seed) < rate * RAND_MAX) 
+					nn->weights[i][k][j] *= (((double)randomNumber(seed) / RAND_MAX) * 0.2) + 0.9;
+					//nn->weights[i][j][k] = (((double)rand() / RAND_MAX) * 4) - 2;
+			}
+
+			if (randomNumber(seed) < rate * RAND_MAX) 
+				nn->biases[i][j] *= (((double)randomNumber(seed) / RAND_MAX) * 0.2) + 0.9;
+				//nn->biases[i][j] = (((double)rand() / RAND_MAX) * 4) - 2;
+		}
+	}
+}
+
 /**
  * @brief This function selects a parent using tournament selection
  * @param tournamentSize - the number of candidates to choose from
@@ -143,11 +239,23 @@ void mutate(neuralNetwork* nn, int generation) {
  * @return the best network from the randomly selected few
  */
 int selectParent(neuralNetwork** candidates, int tournamentSize, double* fitness) {
-	int bestIndex = rand()%populationSize;
+	return selectParentFrom(fitness, populationSize, tournamentSize, NULL);
+}
+
+/**
+ * @brief This function selects a parent using tournament selection, from a population of any size
+ * @param fitness - the fitnesses of all of the networks
+ * @param count - the size of the population
+ * @param tournamentSize - the number of candidates to choose from
+ * @param seed - the seed to use with rand_r, or NULL for rand()
+ * @return the index of the best network from the randomly selected few
+ */
+int selectParentFrom(double* fitness, int count, int tournamentSize, unsigned int* seed) {
+	int bestIndex = randomNumber(seed)%count;
 	double bestFitness = fitness[bestIndex];
 
 	for (int i = 0; i < tournamentSize - 1; i++) {
-		int randomIndex = rand()%populationSize;
+		int randomIndex = randomNumber(seed)%count;
 		double randomFitness = fitness[randomIndex];
 		if (randomFitness > bestFitness) {
 			bestIndex = randomIndex;
@@ -174,23 +282,91 @@ int getBestBrain(double* fitness) {
 	return bestIndex;
 }
 
+static int compareFitness(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief This function gets the median fitness of a generation. Fitness doubles with every food, so
+ * 		  a few lucky networks swamp the average, the median is what most of the population manages.
+ * @param fitness - the fitness of all of the members of the population
+ * @return the median fitness
+ */
+double medianFitness(double* fitness) {
+	double* sorted = malloc(populationSize * sizeof(double));
+	memcpy(sorted, fitness, populationSize * sizeof(double));
+	qsort(sorted, populationSize, sizeof(double), compareFitness);
+	double median = sorted[populationSize / 2];
+	free(sorted);
+	return median;
+}
+
 /**
  * @brief This function trains the neural network for a given number of generations
  * @param population - generation 1 of the training session
  * @param generations - the number of generations to produce
+ * @param options - what else to record while training
  * @return nothing
  */
-void trainNetwork(neuralNetwork** population, int generations) {
+void trainNetwork(neuralNetwork** population, int generations, trainingOptions* options) {
 	neuralNetwork** nextPopulation = calloc(populationSize, sizeof(neuralNetwork*));
 	double* fitness = calloc(populationSize, sizeof(double));
 
+	snake* s = malloc(sizeof(snake));
+	board* b = malloc(sizeof(board));
+	replay* best = malloc(sizeof(replay));
+	initialiseReplay(best);
+
+	datasetRecorder* dataset = NULL;
+	if (options->datasetPath)
+		dataset = openDataset(options->datasetPath, options->datasetSampleRate, options->datasetCompression);
+
+	liveFeed* feed = NULL;
+	if (options->liveFeedName)
+		feed = openLiveFeed(options->liveFeedName);
+
+	frameExporter* exporter = NULL;
+	if (options->exportDirectory)
+		exporter = openFrameExporter(options->exportDirectory, options->exportFormat, options->exportCellSize);
+
+	outcomeLog* outcomes = NULL;
+	if (options->outcomeLogPath)
+		outcomes = openOutcomeLog(options->outcomeLogPath, populationSize, FITNESS_GAMES);
+
+	diversityMonitor* monitor = NULL;
+	diversityStats diversity;
+	if (options->diversity)
+		monitor = openDiversityMonitor(population[0], options->diversityLog);
+
 	initiliseTrainingData(nextPopulation);
 	randomisePopulation(population);
+
+	curriculum* stages = options->curriculum;
+	if (stages)
+		startCurriculumStage(stages, 1);
+
+	struct timespec start, now;
+	int reachedTarget = 0;
+	long games = 0;					//every game played, so runs can be compared by how many they needed
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	
 	for (int i = 0; i < generations; i++) {
-		double averageFitness = getGenerationFitness(population, fitness, i);
+		double averageFitness = getGenerationFitness(population, fitness, i, dataset, outcomes);
+		if (outcomes)
+			writeOutcomeGeneration(outcomes, i+1);
 		//if ((i+1)%20 == 0)
 			printf("Average fitness for Generation%d: %lf\n", i+1, averageFitness);
+		if (monitor) {
+			measureDiversity(monitor, population, populationSize, getBestBrain(fitness), &diversity);
+			logDiversity(monitor, i+1, &diversity);
+		}
+		games += (long)FITNESS_GAMES * populationSize + 1;
+
+		//the tuned elites are bred from straight away, the fitnesses they were picked with are kept
+		if (options->memeticInterval && (i+1) % options->memeticInterval == 0)
+			games += memeticStage(population, fitness, populationSize, i+1);
 		
 		for (int j = 0; j < populationSize-1; j++) {
 			mate(
@@ -207,142 +383,61 @@ void trainNetwork(neuralNetwork** population, int generations) {
 		sprintf(temp, "brains/Generation_%d", i+1);
 		saveBrain(population[bestBrain], temp);
 
+		//one extra game per generation, so this costs nothing next to the fitness games
+		best->header.generation = i+1;
+		b->seed = rand();
+		playCompTrain(population[bestBrain], s, b, best, NULL);
+		appendReplay(best, "brains/replays");
+		free(s->x);
+		free(s->y);
+		if (feed)
+			publishLiveReplay(feed, best, i+1);
+		if (exporter)
+			exportReplay(exporter, best, 0);
+
+		//only games on the full board count, so runs with and without a curriculum can be compared
+		if (options->targetScore && !reachedTarget && (!stages || curriculumFinished(stages)) && best->header.score >= options->targetScore) {
+			reachedTarget = 1;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			printf("Generation%d reached the target score of %d after %.1lf seconds and %ld games\n", i+1, options->targetScore,
+				(now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9, games);
+		}
+		if (stages)
+			promoteCurriculum(stages, medianFitness(fitness), i+1);
+
 		deepCopy(population[bestBrain], population[0]);
 		for (int j = 0; j < populationSize-1; j++) 
 			deepCopy(nextPopulation[j], population[j+1]);
 	}
 
+	if (dataset)
+		closeDataset(dataset);
+	if (feed)
+		closeLiveFeed(feed);
+	if (exporter)
+		closeFrameExporter(exporter);
+	if (monitor)
+		closeDiversityMonitor(monitor);
+	if (outcomes)
+		closeOutcomeLog(outcomes);
+
 	destoryTrainingData(nextPopulation);
+	destroyReplay(best);
+	free(best);
+	free(s);
+	free(b);
 	free(fitness);
 }
 
 /**
- * @brief This function parses the snake game data to nn inputs.
+ * @brief This function parses the snake game data to nn inputs, the work is done by the boards
+ * 	      sensor kernel in snakeGame.c
  * @param nn - the neural network that the stores the parced input
- * @param s - the snake struct, passes not as a refrence because it gets modified, end snake should not
- * 	      change in theory but better safe than sorry.
+ * @param s - the snake struct, it isn't changed
  * @param b - the board struct, has the position of the food and the board dims
  */
 void getInputs(neuralNetwork* nn, snake* s, board* b) {
-	double distance;
-	double maxDistance[] = {
-		(b->width - s->x[0]) + 1,
-		(b->height - s->y[0]) + 1,
-		b->width - (b->width - s->x[0]) + 1,
-		b->height - (b->height- s->y[0]) + 1
-	};
-	int hasCollided;
-	snake* newSnake;
-	newSnake = malloc(sizeof(snake));
-	newSnake->score = s->score;
-	newSnake->hasAte = s->hasAte;
-	newSnake->x = calloc(newSnake->score, sizeof(int));
-	newSnake->y = calloc(newSnake->score, sizeof(int));
-
-	/*
-		These loops and switches are kinda fugly, should be updated at some point
-	*/
-	for (int i = s->direction; i < s->direction + 8; i++) {
-		distance = 0;
-		hasCollided = 0;
-
-		//reset the temp snakes position
-		for (int j = 0; j < newSnake->score; j++) {
-			newSnake->x[j] = s->x[j];
-			newSnake->y[j] = s->y[j];
-		}
-
-		while(!hasCollided && distance < maxDistance[i%4]) {
-			switch (i%8) {
-			case 0:
-				newSnake->x[0]++;
-				break;
-			case 1:
-				newSnake->y[0]++;
-				break;
-			case 2:
-				newSnake->x[0]--;
-				break;
-			case 3:
-				newSnake->y[0]--;
-				break;
-			case 4:
-				newSnake->x[0]++;
-				newSnake->y[0]++;
-				break;
-			case 5:
-				newSnake->y[0]++;
-				newSnake->x[0]--;
-				break;
-			case 6:
-				newSnake->x[0]--;
-				newSnake->y[0]++;
-				break;
-			case 7:
-				newSnake->y[0]--;
-				newSnake->x[0]++;
-				break;
-			}
-
-			hasCollided = snakeFoodCollsion(newSnake, b);
-			distance++;
-		}
-
-		nn->outputs[0][0 + (i - s->direction)] = distance < maxDistance[i%4] ? distance : 0;
-	}
-
-	for (int i = s->direction; i < s->direction + 8; i++) {
-		distance = 0;
-		hasCollided = 0;
-
-		//reset the temp snakes position
-		for (int j = 0; j < newSnake->score; j++) {
-			newSnake->x[j] = s->x[j];
-			newSnake->y[j] = s->y[j];
-		}
-
-		while(!hasCollided && distance < maxDistance[i%4]) {
-			switch (i%8) {
-			case 0:
-				newSnake->x[0]++;
-				break;
-			case 1:
-				newSnake->y[0]++;
-				break;
-			case 2:
-				newSnake->x[0]--;
-				break;
-			case 3:
-				newSnake->y[0]--;
-				break;
-			case 4:
-				newSnake->x[0]++;
-				newSnake->y[0]++;
-				break;
-			case 5:
-				newSnake->y[0]++;
-				newSnake->x[0]--;
-				break;
-			case 6:
-				newSnake->x[0]--;
-				newSnake->y[0]++;
-				break;
-			case 7:
-				newSnake->y[0]--;
-				newSnake->x[0]++;
-				break;
-			}
-
-			hasCollided = snakeCollison(newSnake, b);
-			distance++;
-		}
-
-		nn->outputs[0][8 + (i - s->direction)] = 1/distance;
-	}
-
-	free(newSnake->x);
-	free(newSnake->y);
-	free(newSnake);
+	senseBoard(s, b, nn->outputs[0]);
 }
 
 /**
@@ -351,13 +446,24 @@ void getInputs(neuralNetwork* nn, snake* s, board* b) {
  * @return the index of the most active output.
  */
 int getOutput(neuralNetwork* nn) {
-		int max = nn->outputs[nn->networkSize-1][0];
+		return getOutputFrom(nn->outputs[nn->networkSize-1], nn->networkLayout[nn->networkSize - 1]);
+}
+
+/**
+ * @brief This function picks the move from a row of output neurons, the way every brain was trained
+ * 		  to, the running maximum is kept as an int so outputs are compared truncated
+ * @param outputs - the output layer
+ * @param count - the number of outputs
+ * @return the index of the most active output.
+ */
+int getOutputFrom(const double* outputs, int count) {
+		int max = outputs[0];
 		int maxIndex = 0;
-		for (int i = 1; i < nn->networkLayout[nn->networkSize - 1]; i++) {
-			if (nn->outputs[nn->networkSize-1][i] > max) {
+		for (int i = 1; i < count; i++) {
+			if (outputs[i] > max) {
 				maxIndex = i;
-				max = nn->outputs[nn->networkSize-1][i];
+				max = outputs[i];
 			}
 		}
 		return maxIndex;
-}
\ No newline at end of file
+}
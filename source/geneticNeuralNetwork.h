@@ -2,21 +2,64 @@
 #include "neuralNetworkShell.h"
 #include "snakeGame.h"
 #include "main.h"
+#include "datasetRecorder.h"
+#include "liveFeed.h"
+#include "frameExport.h"
+#include "curriculum.h"
+#include "diversityMonitor.h"
+#include "memetic.h"
+#include "outcomeLog.h"
 
 #define mutationRate 0.25
 #define populationSize 10000
+#define FITNESS_GAMES 3					//games each network plays for its fitness
+#define TRAINING_GENERATIONS 100		//generations train runs, for either algorithm, when --generations is not given
 
 #define max(a,b) (a>b)?a:b
 
+enum fitnessFormula {
+	FITNESS_EXPONENTIAL,			//2^score * time/150, what training uses
+	FITNESS_SCORE,					//the score alone
+	FITNESS_LOG						//log10(time * 2^score)
+};
+typedef enum fitnessFormula fitnessFormula;
+
+struct trainingOptions {
+	const char* datasetPath;		//if not NULL, sampled ticks from every training game are exported here
+	double datasetSampleRate;		//the fraction of ticks exported
+	int datasetCompression;			//if not 0 the dataset chunks are compressed
+	const char* liveFeedName;		//if not NULL, the best game of each generation is published here for viewers
+	const char* exportDirectory;	//if not NULL, the best game of each generation is rendered into this directory
+	exportFormat exportFormat;
+	int exportCellSize;				//pixels per board cell of the exported frames
+	curriculum* curriculum;			//if not NULL, training starts on the curriculums smaller boards
+	int targetScore;				//if not 0, the time until a best game on the full board scores this is reported
+	int diversity;					//if not 0, the populations diversity is reported every generation
+	const char* diversityLog;		//if not NULL, the diversity is also written to this csv file
+	int memeticInterval;			//if not 0, the elites are fine tuned with backpropagation every this many generations
+	int esPairs;					//if not 0, evolution strategies with this many pairs is trained instead
+	int generations;				//generations trained by either algorithm
+	int threads;					//threads evolution strategies uses, 0 for one per core
+	const char* outcomeLogPath;		//if not NULL, every individuals games are written here each generation
+};
+typedef struct trainingOptions trainingOptions;
+
+void initialiseTrainingOptions(trainingOptions*);
 void initiliseTrainingData(neuralNetwork**);
 void destoryTrainingData(neuralNetwork**);
 void randomisePopulation(neuralNetwork**);
-long double getFitness(neuralNetwork*, int);
-double getGenerationFitness(neuralNetwork**, double*, int);
+long double getFitness(neuralNetwork*, int, datasetRecorder*, outcomeLog*, int);
+double gameFitness(snake*, fitnessFormula);
+double getGenerationFitness(neuralNetwork**, double*, int, datasetRecorder*, outcomeLog*);
 void mate(neuralNetwork*, neuralNetwork*, neuralNetwork*);
+void mateWith(neuralNetwork*, neuralNetwork*, neuralNetwork*, unsigned int*);
 void mutate(neuralNetwork*, int);
+void mutateWith(neuralNetwork*, double, unsigned int*);
 int selectParent(neuralNetwork**, int, double*);
+int selectParentFrom(double*, int, int, unsigned int*);
 int getBestBrain(double*);
-void trainNetwork(neuralNetwork**, int);
+double medianFitness(double*);
+void trainNetwork(neuralNetwork**, int, trainingOptions*);
 void getInputs(neuralNetwork*, snake*, board*);
-int getOutput(neuralNetwork*);
\ No newline at end of file
+int getOutput(neuralNetwork*);
+int getOutputFrom(const double*, int);
\ No newline at end of file
@@ -0,0 +1,471 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "inferenceDaemon.h"
+#include "neuralNetworkShell.h"
+#include "geneticNeuralNetwork.h"
+#include "snakeGame.h"
+
+struct daemonJob {
+	struct daemonJob* next;
+	double inputs[NETWORK_INPUTS];		//loadBrain only accepts brains with this many inputs
+	uint32_t id;
+	int brain;
+	int move;
+	int done;
+	uint64_t received;			//nanoseconds, from the monotonic clock
+	pthread_cond_t finished;
+};
+typedef struct daemonJob daemonJob;
+
+struct inferenceDaemon {
+	neuralNetwork** brains;
+	int brainCount;
+
+	pthread_mutex_t lock;
+	pthread_cond_t queueNotEmpty;
+	daemonJob* head;
+	daemonJob* tail;
+	int queued;
+	int clients;				//each connection has at most one request in flight
+
+	uint64_t* latencies;
+	uint64_t* finishedAt;		//when each latency sample was taken, so old ones can be left out
+	long long completed;
+	long long batches;
+};
+typedef struct inferenceDaemon inferenceDaemon;
+
+struct daemonClient {
+	inferenceDaemon* d;
+	int socket;
+};
+typedef struct daemonClient daemonClient;
+
+static volatile sig_atomic_t daemonRunning = 1;
+
+static void stopDaemon(int signal) {
+	(void)signal;
+	daemonRunning = 0;
+}
+
+/**
+ * @brief This function starts a worker thread with SIGINT and SIGTERM blocked, so they always
+ * 		  interrupt the accept loop on the main thread
+ * @param thread - the thread handle to fill in
+ * @param worker - the function the thread runs
+ * @param arg - passed to worker
+ * @return nothing
+ */
+static void startWorker(pthread_t* thread, void* (*worker)(void*), void* arg) {
+	sigset_t stopSignals, previous;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+
+	pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+	pthread_create(thread, NULL, worker, arg);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+static uint64_t nowNanoseconds() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static int readFully(int fd, void* buffer, size_t size) {
+	char* p = buffer;
+	while (size) {
+		ssize_t n = read(fd, p, size);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			return 0;
+		}
+		p += n;
+		size -= n;
+	}
+	return 1;
+}
+
+static int writeFully(int fd, const void* buffer, size_t size) {
+	const char* p = buffer;
+	while (size) {
+		ssize_t n = write(fd, p, size);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			return 0;
+		}
+		p += n;
+		size -= n;
+	}
+	return 1;
+}
+
+static int compareLatencies(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief This function prints the request rate, the mean batch size and the p50/p99 latency
+ * @param d - the daemon, its lock must be held
+ * @param seconds - the time the counts were collected over
+ * @param requests - the requests completed in that time
+ * @param batches - the forward passes run in that time
+ * @param since - only latencies of requests finished at or after this time are used
+ * @return nothing
+ */
+static void printDaemonStats(inferenceDaemon* d, double seconds, long long requests, long long batches, uint64_t since) {
+	int kept = d->completed < DAEMON_LATENCY_SAMPLES ? (int)d->completed : DAEMON_LATENCY_SAMPLES;
+	if (!kept || !requests)
+		return;
+
+	uint64_t* sorted = malloc(kept * sizeof(uint64_t));
+	int samples = 0;
+	for (int i = 0; i < kept; i++)
+		if (d->finishedAt[i] >= since)
+			sorted[samples++] = d->latencies[i];
+	if (!samples) {
+		free(sorted);
+		return;
+	}
+	qsort(sorted, samples, sizeof(uint64_t), compareLatencies);
+
+	printf("%.0lf requests/sec, %.1lf per batch, p50 %.1lfus, p99 %.1lfus\n",
+		requests / seconds, (double)requests / batches,
+		sorted[samples / 2] / 1000.0, sorted[(int)(samples * 0.99)] / 1000.0);
+	fflush(stdout);
+	free(sorted);
+}
+
+/**
+ * @brief This function runs every coalesced batch through the brain it asked for
+ * @param d - the daemon
+ * @param batch - the jobs to run
+ * @param count - the number of jobs
+ * @return the number of forward passes that were run
+ */
+static int runBatch(inferenceDaemon* d, daemonJob** batch, int count) {
+	int passes = 0;
+
+	for (int brain = 0; brain < d->brainCount; brain++) {
+		neuralNetwork* nn = d->brains[brain];
+		int inputSize = nn->networkLayout[0];
+		int outputSize = nn->networkLayout[nn->networkSize-1];
+		double inputs[DAEMON_MAX_BATCH * inputSize];
+		double outputs[DAEMON_MAX_BATCH * outputSize];
+		daemonJob* jobs[DAEMON_MAX_BATCH];
+		int n = 0;
+
+		for (int i = 0; i < count; i++) {
+			if (batch[i]->brain == brain) {
+				memcpy(&inputs[n * inputSize], batch[i]->inputs, inputSize * sizeof(double));
+				jobs[n++] = batch[i];
+			}
+		}
+		if (!n)
+			continue;
+
+		batchFrontPropegation(nn, inputs, outputs, n);
+		passes++;
+
+		//the same pick as getOutput, so a served brain plays the moves it was trained with
+		for (int i = 0; i < n; i++)
+			jobs[i]->move = getOutputFrom(&outputs[i * outputSize], outputSize);
+	}
+	return passes;
+}
+
+/**
+ * @brief This function is the batching thread, it waits for requests, gives each batch a short
+ * 		  window to fill up, runs it and wakes up the clients that were waiting on it.
+ * @param arg - the daemon
+ * @return nothing
+ */
+static void* batchWorker(void* arg) {
+	inferenceDaemon* d = arg;
+	daemonJob* batch[DAEMON_MAX_BATCH];
+	uint64_t lastReport = nowNanoseconds();
+	long long reportCompleted = 0;
+	long long reportBatches = 0;
+
+	pthread_mutex_lock(&d->lock);
+	while (daemonRunning) {
+		struct timespec wake;
+		clock_gettime(CLOCK_REALTIME, &wake);
+		wake.tv_sec += 1;
+		while (!d->queued && daemonRunning)
+			if (pthread_cond_timedwait(&d->queueNotEmpty, &d->lock, &wake) == ETIMEDOUT)
+				break;
+
+		//no point waiting for more requests than there are connections to send them
+		int expected = d->clients < DAEMON_MAX_BATCH ? d->clients : DAEMON_MAX_BATCH;
+		if (d->queued && d->queued < expected) {
+			clock_gettime(CLOCK_REALTIME, &wake);
+			wake.tv_nsec += DAEMON_BATCH_WINDOW_US * 1000;
+			if (wake.tv_nsec >= 1000000000) {
+				wake.tv_sec++;
+				wake.tv_nsec -= 1000000000;
+			}
+			while (d->queued < expected && d->queued < d->clients)
+				if (pthread_cond_timedwait(&d->queueNotEmpty, &d->lock, &wake) == ETIMEDOUT)
+					break;
+		}
+
+		int count = 0;
+		while (d->head && count < DAEMON_MAX_BATCH) {
+			batch[count++] = d->head;
+			d->head = d->head->next;
+			d->queued--;
+		}
+		if (!d->head)
+			d->tail = NULL;
+
+		if (count) {
+			pthread_mutex_unlock(&d->lock);
+			int passes = runBatch(d, batch, count);
+			uint64_t now = nowNanoseconds();
+			pthread_mutex_lock(&d->lock);
+
+			for (int i = 0; i < count; i++) {
+				d->latencies[d->completed % DAEMON_LATENCY_SAMPLES] = now - batch[i]->received;
+				d->finishedAt[d->completed++ % DAEMON_LATENCY_SAMPLES] = now;
+				batch[i]->done = 1;
+				pthread_cond_signal(&batch[i]->finished);
+			}
+			d->batches += passes;
+		}
+
+		uint64_t now = nowNanoseconds();
+		if (now - lastReport >= DAEMON_REPORT_SECONDS * 1000000000ull) {
+			printDaemonStats(d, (now - lastReport) / 1e9, d->completed - reportCompleted, d->batches - reportBatches, lastReport);
+			reportCompleted = d->completed;
+			reportBatches = d->batches;
+			lastReport = now;
+		}
+	}
+	pthread_mutex_unlock(&d->lock);
+	return NULL;
+}
+
+/**
+ * @brief This function turns a raw board payload into network inputs by running getInputs server side
+ * @param payload - the daemonRawBoard and the body that follows it
+ * @param length - the payload size in bytes
+ * @param scratch - a network with a 16 input layer, only its inputs are written
+ * @param inputs - where the inputs are copied to
+ * @return 1 if the payload was valid, 0 otherwise
+ */
+static int rawBoardInputs(const uint8_t* payload, int length, neuralNetwork* scratch, double* inputs) {
+	daemonRawBoard raw;
+	if (length < (int)sizeof(daemonRawBoard))
+		return 0;
+	memcpy(&raw, payload, sizeof(daemonRawBoard));
+
+	if (raw.bodyLength < 1 || raw.bodyLength > DAEMON_MAX_BODY || raw.direction > 3 ||
+			length != (int)sizeof(daemonRawBoard) + 2 * raw.bodyLength)
+		return 0;
+
+	const uint8_t* body = payload + sizeof(daemonRawBoard);
+	board b = {.height = raw.height, .width = raw.width, .foodX = raw.foodX, .foodY = raw.foodY};
+	snake s = {0};
+	s.score = raw.bodyLength + raw.hasAte;
+	s.hasAte = raw.hasAte;
+	s.direction = raw.direction;
+	s.alive = 1;
+	s.x = calloc(s.score, sizeof(int));
+	s.y = calloc(s.score, sizeof(int));
+	for (int i = 0; i < raw.bodyLength; i++) {
+		s.x[i] = body[2*i];
+		s.y[i] = body[2*i + 1];
+	}
+	setBoardKernel(&s, &b);
+
+	getInputs(scratch, &s, &b);
+	memcpy(inputs, scratch->outputs[0], scratch->networkLayout[0] * sizeof(double));
+
+	free(s.x);
+	free(s.y);
+	return 1;
+}
+
+/**
+ * @brief This function serves one connection, one request at a time. Requests from different
+ * 		  connections are coalesced by the batching thread.
+ * @param arg - the daemonClient, freed on exit
+ * @return nothing
+ */
+static void* clientWorker(void* arg) {
+	daemonClient* client = arg;
+	inferenceDaemon* d = client->d;
+	uint8_t payload[sizeof(daemonRawBoard) + 2 * DAEMON_MAX_BODY];
+	daemonRequestHeader header;
+	daemonResponse response = {0};
+	daemonJob job;
+
+	neuralNetwork* scratch = malloc(sizeof(neuralNetwork));
+	initialiseNetworkBrain(scratch);
+	pthread_cond_init(&job.finished, NULL);
+
+	while (readFully(client->socket, &header, sizeof(header))) {
+		uint64_t received = nowNanoseconds();
+		if (header.length > sizeof(payload) || !readFully(client->socket, payload, header.length))
+			break;
+
+		response.id = header.id;
+		response.move = 0;
+		response.status = DAEMON_OK;
+
+		if (header.brain >= d->brainCount) {
+			response.status = DAEMON_BAD_BRAIN;
+		} else if (header.kind == DAEMON_FEATURES) {
+			int inputSize = d->brains[header.brain]->networkLayout[0];
+			if (header.length != inputSize * sizeof(float)) {
+				response.status = DAEMON_BAD_REQUEST;
+			} else {
+				for (int i = 0; i < inputSize; i++) {
+					float input;
+					memcpy(&input, &payload[i * sizeof(float)], sizeof(float));
+					job.inputs[i] = input;
+				}
+			}
+		} else if (header.kind == DAEMON_RAW_BOARD) {
+			if (d->brains[header.brain]->networkLayout[0] != scratch->networkLayout[0] ||
+					!rawBoardInputs(payload, header.length, scratch, job.inputs))
+				response.status = DAEMON_BAD_REQUEST;
+		} else {
+			response.status = DAEMON_BAD_REQUEST;
+		}
+
+		if (response.status == DAEMON_OK) {
+			job.id = header.id;
+			job.brain = header.brain;
+			job.done = 0;
+			job.next = NULL;
+			job.received = received;
+
+			pthread_mutex_lock(&d->lock);
+			if (d->tail)
+				d->tail->next = &job;
+			else
+				d->head = &job;
+			d->tail = &job;
+			d->queued++;
+			pthread_cond_signal(&d->queueNotEmpty);
+
+			while (!job.done)
+				pthread_cond_wait(&job.finished, &d->lock);
+			pthread_mutex_unlock(&d->lock);
+
+			response.move = job.move;
+		}
+
+		if (!writeFully(client->socket, &response, sizeof(response)))
+			break;
+	}
+
+	pthread_mutex_lock(&d->lock);
+	d->clients--;
+	pthread_mutex_unlock(&d->lock);
+
+	close(client->socket);
+	pthread_cond_destroy(&job.finished);
+	destroyBrainData(scratch);
+	free(scratch);
+	free(client);
+	return NULL;
+}
+
+/**
+ * @brief This function preloads the brains and serves moves over a unix domain socket until
+ * 		  it gets SIGINT or SIGTERM, then prints the final latency report.
+ * @param socketPath - the path of the socket to listen on, replaced if it already exists
+ * @param brainPaths - the brains to load, requests pick one by its index
+ * @param brainCount - the number of brains
+ * @return 1 if the daemon shut down cleanly, 0 if it could not start
+ */
+int runInferenceDaemon(const char* socketPath, const char** brainPaths, int brainCount) {
+	inferenceDaemon* d = calloc(1, sizeof(inferenceDaemon));
+	d->brainCount = brainCount;
+	d->brains = calloc(brainCount, sizeof(neuralNetwork*));
+	d->latencies = calloc(DAEMON_LATENCY_SAMPLES, sizeof(uint64_t));
+	d->finishedAt = calloc(DAEMON_LATENCY_SAMPLES, sizeof(uint64_t));
+	pthread_mutex_init(&d->lock, NULL);
+	pthread_cond_init(&d->queueNotEmpty, NULL);
+
+	for (int i = 0; i < brainCount; i++) {
+		d->brains[i] = malloc(sizeof(neuralNetwork));
+		initialiseNetworkBrain(d->brains[i]);
+		loadBrain(d->brains[i], brainPaths[i]);
+	}
+
+	struct sockaddr_un address = {0};
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path)) {
+		printf("Socket path too long\n");
+		return 0;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath);
+	if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 128) != 0) {
+		printf("Could not listen on %s: %s\n", socketPath, strerror(errno));
+		return 0;
+	}
+
+	//no SA_RESTART, so accept returns when we are asked to stop
+	struct sigaction action = {0};
+	action.sa_handler = stopDaemon;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	pthread_t batcher;
+	startWorker(&batcher, batchWorker, d);
+	printf("Serving %d brain(s) on %s\n", brainCount, socketPath);
+	fflush(stdout);
+
+	uint64_t started = nowNanoseconds();
+	while (daemonRunning) {
+		int connection = accept(listener, NULL, NULL);
+		if (connection < 0)
+			continue;
+
+		daemonClient* client = malloc(sizeof(daemonClient));
+		client->d = d;
+		client->socket = connection;
+
+		pthread_mutex_lock(&d->lock);
+		d->clients++;
+		pthread_mutex_unlock(&d->lock);
+
+		pthread_t thread;
+		startWorker(&thread, clientWorker, client);
+		pthread_detach(thread);
+	}
+
+	pthread_join(batcher, NULL);
+	close(listener);
+	unlink(socketPath);
+
+	pthread_mutex_lock(&d->lock);
+	printf("Served %lld requests in %lld forward passes\n", d->completed, d->batches);
+	printDaemonStats(d, (nowNanoseconds() - started) / 1e9, d->completed, d->batches, started);
+	pthread_mutex_unlock(&d->lock);
+
+	//clients that are still connected keep their pointers, so the brains live until exit
+	return 1;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+#include "neuralNetworkShell.h"
+
+#define DAEMON_MAX_BATCH 64				//most requests that are coalesced into one forward pass
+#define DAEMON_BATCH_WINDOW_US 200		//how long the first request of a batch waits for company
+#define DAEMON_LATENCY_SAMPLES 65536	//most recent latencies kept for the p50/p99 report
+#define DAEMON_REPORT_SECONDS 5			//how often the stats are printed, and how far back their latencies go
+#define DAEMON_MAX_BODY 4096			//longest snake accepted in a raw board request
+
+/*
+	Every message on the socket is little endian and starts with a fixed 8 byte header.
+	A request is followed by header.length bytes of payload:
+		DAEMON_FEATURES  - networkLayout[0] float32 inputs, as produced by getInputs
+		DAEMON_RAW_BOARD - a daemonRawBoard followed by bodyLength (x, y) uint8 pairs, head first,
+						   the daemon runs getInputs itself
+	Every request gets exactly one daemonResponse, move is the index getOutput would return
+	(0 left, 1 forward, 2 right).
+*/
+enum daemonRequestKind {
+	DAEMON_FEATURES = 0,
+	DAEMON_RAW_BOARD = 1
+};
+
+enum daemonStatus {
+	DAEMON_OK = 0,
+	DAEMON_BAD_BRAIN = 1,
+	DAEMON_BAD_REQUEST = 2
+};
+
+struct daemonRequestHeader {
+	uint32_t id;				//echoed back in the response
+	uint8_t brain;				//index into the brains the daemon was started with
+	uint8_t kind;				//a daemonRequestKind
+	uint16_t length;			//payload bytes that follow
+};
+typedef struct daemonRequestHeader daemonRequestHeader;
+
+struct daemonRawBoard {
+	uint8_t width;
+	uint8_t height;
+	uint8_t foodX;
+	uint8_t foodY;
+	uint8_t direction;			//0-right, 1-down, 2-left, 3-up
+	uint8_t hasAte;
+	uint16_t bodyLength;
+};
+typedef struct daemonRawBoard daemonRawBoard;
+
+struct daemonResponse {
+	uint32_t id;
+	uint8_t move;
+	uint8_t status;				//a daemonStatus
+	uint16_t reserved;
+};
+typedef struct daemonResponse daemonResponse;
+
+int runInferenceDaemon(const char*, const char**, int);
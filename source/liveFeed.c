@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "liveFeed.h"
+#include "snakeGame.h"
+#include "replay.h"
+
+/**
+ * @brief This function works out the size of a feeds shared memory object
+ * @return the size in bytes
+ */
+static size_t liveFeedSize() {
+	return sizeof(liveFeedHeader) + (size_t)LIVE_FEED_SLOTS * sizeof(liveFeedSlot);
+}
+
+/**
+ * @brief This function creates the shared memory for a feed, replacing any left over from an
+ * 		  earlier run. Viewers still attached to the old one keep it until they detach.
+ * @param name - the shared memory object, e.g. LIVE_FEED_NAME
+ * @return the feed, or NULL if the shared memory could not be created
+ */
+liveFeed* openLiveFeed(const char* name) {
+	size_t size = liveFeedSize();
+
+	//a new object rather than truncating the old one, which would crash viewers still reading it
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd == -1) {
+		printf("Could not create the live feed %s\n", name);
+		return NULL;
+	}
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		shm_unlink(name);
+		printf("Could not create the live feed %s\n", name);
+		return NULL;
+	}
+
+	void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		shm_unlink(name);
+		printf("Could not create the live feed %s\n", name);
+		return NULL;
+	}
+
+	liveFeed* feed = calloc(1, sizeof(liveFeed));
+	snprintf(feed->name, sizeof(feed->name), "%s", name);
+	feed->writer = 1;
+	feed->size = size;
+	feed->header = map;
+	feed->slots = (liveFeedSlot*)(feed->header + 1);
+
+	//the memory starts zeroed, so every slot is an empty, unwritten seqlock
+	feed->header->version = LIVE_FEED_VERSION;
+	feed->header->slotCount = LIVE_FEED_SLOTS;
+	feed->header->slotSize = sizeof(liveFeedSlot);
+	feed->header->pid = getpid();
+	atomic_store(&feed->header->open, 1);
+	atomic_store_explicit(&feed->header->head, 0, memory_order_release);
+	atomic_thread_fence(memory_order_release);
+	feed->header->magic = LIVE_FEED_MAGIC;
+
+	printf("Publishing the best game of each generation to %s\n", name);
+	return feed;
+}
+
+/**
+ * @brief This function publishes one frame. It never waits, a viewer that is reading the slot
+ * 		  being overwritten notices and throws its copy away.
+ * @param feed - the feed
+ * @param s - the snake
+ * @param b - the board
+ * @param generation - the generation the game is from
+ * @param tick - the tick of the game, 0 for its first frame
+ * @return nothing
+ */
+void publishLiveFrame(liveFeed* feed, snake* s, board* b, int generation, int tick) {
+	uint64_t frame = feed->next++;
+	liveFeedSlot* slot = &feed->slots[frame % LIVE_FEED_SLOTS];
+
+	atomic_store_explicit(&slot->sequence, frame * 2 + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	//written straight into the shared memory, there is no staging copy
+	slot->frame.generation = generation;
+	slot->frame.tick = tick;
+	takeSnapshot(s, b, &slot->frame.snapshot);
+
+	atomic_store_explicit(&slot->sequence, frame * 2 + 2, memory_order_release);
+	atomic_store_explicit(&feed->header->head, frame + 1, memory_order_release);
+}
+
+/**
+ * @brief This function publishes every frame of a recorded game, by playing it again from its
+ * 		  seed, so the game itself can be played at full speed without the feed
+ * @param feed - the feed
+ * @param r - the recorded game
+ * @param generation - the generation the game is from
+ * @return nothing
+ */
+void publishLiveReplay(liveFeed* feed, replay* r, int generation) {
+	snake s;
+	board b;
+
+	seekReplay(r, &s, &b, 0);
+	publishLiveFrame(feed, &s, &b, generation, 0);
+	for (int i = 0; i < (int)r->header.ticks; i++) {
+		s.move = getReplayMove(r, i);
+		updateSnake(&s, &b);
+		publishLiveFrame(feed, &s, &b, generation, i + 1);
+	}
+
+	free(s.x);
+	free(s.y);
+}
+
+/**
+ * @brief This function tells viewers training has finished and removes the feed
+ * @param feed - the feed
+ * @return nothing
+ */
+void closeLiveFeed(liveFeed* feed) {
+	atomic_store(&feed->header->open, 0);
+	munmap(feed->header, feed->size);
+	shm_unlink(feed->name);
+	free(feed);
+}
+
+/**
+ * @brief This function copies a frame out of the feed, if it is still there
+ * @param feed - the feed
+ * @param frame - the frame number
+ * @param out - where the frame is copied to
+ * @return 1 if the frame was copied whole, 0 if it hasn't been written or has been overwritten
+ */
+static int copyLiveFrame(liveFeed* feed, uint64_t frame, liveFrame* out) {
+	liveFeedSlot* slot = &feed->slots[frame % LIVE_FEED_SLOTS];
+	uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+	if (sequence != frame * 2 + 2)
+		return 0;
+
+	//only the part of the snapshot in use is copied, the length is clamped as it may be torn
+	out->generation = slot->frame.generation;
+	out->tick = slot->frame.tick;
+	memcpy(&out->snapshot, &slot->frame.snapshot, offsetof(boardSnapshot, x));
+	int length = out->snapshot.length;
+	if (length < 0 || length > SNAPSHOT_MAX_CELLS)
+		length = 0;
+	memcpy(out->snapshot.x, slot->frame.snapshot.x, length);
+	memcpy(out->snapshot.y, slot->frame.snapshot.y, length);
+
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence;
+}
+
+/**
+ * @brief This function attaches to a feed a trainer is publishing, reading only. The viewer starts
+ * 		  at the beginning of the newest game still in the feed.
+ * @param name - the shared memory object
+ * @return the feed, or NULL if there is no trainer publishing to it
+ */
+liveFeed* attachLiveFeed(const char* name) {
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd == -1)
+		return NULL;
+
+	struct stat info;
+	size_t size = liveFeedSize();
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size != size) {
+		close(fd);
+		return NULL;
+	}
+
+	void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	liveFeed* feed = calloc(1, sizeof(liveFeed));
+	snprintf(feed->name, sizeof(feed->name), "%s", name);
+	feed->size = size;
+	feed->header = map;
+	feed->slots = (liveFeedSlot*)(feed->header + 1);
+
+	liveFeedHeader* header = feed->header;
+	if (header->magic != LIVE_FEED_MAGIC || header->version != LIVE_FEED_VERSION ||
+		header->slotCount != LIVE_FEED_SLOTS || header->slotSize != sizeof(liveFeedSlot)) {
+		detachLiveFeed(feed);
+		return NULL;
+	}
+
+	uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+	uint64_t oldest = head > LIVE_FEED_SLOTS ? head - LIVE_FEED_SLOTS : 0;
+	liveFrame* frame = malloc(sizeof(liveFrame));
+	feed->next = head;
+	for (uint64_t i = head; i > oldest; i--) {
+		if (copyLiveFrame(feed, i - 1, frame) && frame->tick == 0) {
+			feed->next = i - 1;
+			break;
+		}
+	}
+	free(frame);
+	return feed;
+}
+
+/**
+ * @brief This function reads the next frame of the feed. If the trainer has lapped the viewer,
+ * 		  the frames that were overwritten are skipped.
+ * @param feed - an attached feed
+ * @param frame - where the frame is copied to
+ * @return 1 if there was a new frame, 0 if the viewer has caught up
+ */
+int readLiveFrame(liveFeed* feed, liveFrame* frame) {
+	for (int tries = 0; tries < 4; tries++) {
+		uint64_t head = atomic_load_explicit(&feed->header->head, memory_order_acquire);
+		if (feed->next >= head)
+			return 0;
+
+		//a quarter of the ring is left as a margin, so the jump isn't straight into the writer
+		if (head - feed->next > LIVE_FEED_SLOTS) {
+			uint64_t next = head - LIVE_FEED_SLOTS + LIVE_FEED_SLOTS / 4;
+			feed->skipped += next - feed->next;
+			feed->next = next;
+		}
+
+		if (copyLiveFrame(feed, feed->next, frame)) {
+			feed->next++;
+			return 1;
+		}
+
+		//overwritten while it was being copied
+		feed->skipped++;
+		feed->next++;
+	}
+	return 0;
+}
+
+/**
+ * @brief This function checks the trainer is still publishing to a feed
+ * @param feed - an attached feed
+ * @return 1 if it is, 0 if training finished or the trainer was killed
+ */
+int liveFeedAlive(liveFeed* feed) {
+	if (!atomic_load(&feed->header->open))
+		return 0;
+	return kill(feed->header->pid, 0) == 0 || errno == EPERM;
+}
+
+/**
+ * @brief This function detaches a viewer from a feed
+ * @param feed - the feed
+ * @return nothing
+ */
+void detachLiveFeed(liveFeed* feed) {
+	munmap(feed->header, feed->size);
+	free(feed);
+}
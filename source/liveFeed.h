@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "snakeGame.h"
+#include "replay.h"
+
+#define LIVE_FEED_MAGIC 0x4c4b4e53		//"SNKL"
+#define LIVE_FEED_VERSION 1
+#define LIVE_FEED_NAME "/snake-live"	//the default shared memory object, in /dev/shm on linux
+#define LIVE_FEED_SLOTS 2048			//frames kept, a viewer further behind than this skips ahead
+
+/*
+	A live feed is one shared memory object: a liveFeedHeader followed by LIVE_FEED_SLOTS slots. The
+	trainer is the only writer, it writes frame n into slot n % LIVE_FEED_SLOTS and then sets head to
+	n + 1. Each slot is a seqlock, sequence is odd while the slot is being written and 2 * (n + 1)
+	once frame n is in it. A viewer copies a frame out and checks the sequence didn't change while it
+	was copying, so the trainer never waits for, or even knows about, the viewers.
+*/
+struct liveFeedHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotSize;
+	_Atomic uint64_t head;			//frames published so far
+	_Atomic int32_t open;			//cleared when training finishes
+	int32_t pid;					//the trainer, so viewers can tell if it was killed
+};
+typedef struct liveFeedHeader liveFeedHeader;
+
+struct liveFrame {
+	int32_t generation;
+	int32_t tick;					//0 on the first frame of a game
+	boardSnapshot snapshot;
+};
+typedef struct liveFrame liveFrame;
+
+struct liveFeedSlot {
+	_Atomic uint64_t sequence;
+	liveFrame frame;
+};
+typedef struct liveFeedSlot liveFeedSlot;
+
+struct liveFeed {
+	char name[256];
+	int writer;
+	size_t size;
+	liveFeedHeader* header;
+	liveFeedSlot* slots;
+	uint64_t next;					//the next frame to write, or for a viewer the next to read
+	uint64_t skipped;				//frames a viewer missed because the trainer lapped it
+};
+typedef struct liveFeed liveFeed;
+
+liveFeed* openLiveFeed(const char*);
+void publishLiveFrame(liveFeed*, snake*, board*, int, int);
+void publishLiveReplay(liveFeed*, replay*, int);
+void closeLiveFeed(liveFeed*);
+
+liveFeed* attachLiveFeed(const char*);
+int readLiveFrame(liveFeed*, liveFrame*);
+int liveFeedAlive(liveFeed*);
+void detachLiveFeed(liveFeed*);
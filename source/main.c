@@ -6,8 +6,99 @@
 #include "snakeGame.h"
 #include "snakeGraphics.h"
 #include "geneticNeuralNetwork.h"
+#include "quantisedNetwork.h"
+#include "inferenceDaemon.h"
+#include "brainEvaluation.h"
+#include "replay.h"
+#include "frameScheduler.h"
+#include "spectatorView.h"
+#include "liveFeed.h"
+#include "frameExport.h"
+#include "curriculum.h"
+#include "sweep.h"
+#include "evolutionStrategies.h"
 #include "main.h"
 
+//the starvation budgets of training games, changed by the curriculum as training goes on
+static int startBudget = STARVATION_BUDGET;
+static int foodBudget = FOOD_BUDGET;
+
+/**
+ * @brief This function handles the keys every play mode shares: +/- change the speed, 0 toggles
+ * 		  unthrottled, space pauses and tab toggles the stats overlay.
+ * 		  Also redraws the whole board if the renderer lost its textures.
+ * @param win - the game window and the renderer
+ * @param f - the frame scheduler of the game
+ * @param e - the event
+ * @param showStats - toggled by tab
+ * @return 1 if the event was handled, 0 otherwise
+ */
+static int handleFrameKeys(renderWindow* win, frameScheduler* f, SDL_Event* e, int* showStats) {
+	if (e->type == SDL_RENDER_TARGETS_RESET || e->type == SDL_RENDER_DEVICE_RESET) {
+		invalidateBoard(win);
+		redrawFrame(f);
+		return 1;
+	}
+	if (e->type != SDL_KEYDOWN)
+		return 0;
+
+	switch (e->key.keysym.sym) {
+	case SDLK_EQUALS:
+	case SDLK_PLUS:
+		changeFrameSpeed(f, 2);
+		return 1;
+	case SDLK_MINUS:
+		changeFrameSpeed(f, 0.5);
+		return 1;
+	case SDLK_0:
+		changeFrameSpeed(f, f->unthrottled ? 0.5 : FRAME_MAX_SPEED * 2);
+		return 1;
+	case SDLK_SPACE:
+		toggleFramePause(f);
+		return 1;
+	case SDLK_TAB:
+		*showStats = !*showStats;
+		redrawFrame(f);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief This function draws and presents a frame, with the stats overlay if it is on
+ * @param win - the game window and the renderer
+ * @param s - the snake
+ * @param b - the board
+ * @param f - the frame scheduler of the game
+ * @param showStats - if 0 only the board is drawn
+ * @param nn - if not NULL, the networks last inputs are shown in the overlay too
+ * @return nothing
+ */
+static void renderFrame(renderWindow* win, snake* s, board* b, frameScheduler* f, int showStats, neuralNetwork* nn) {
+	drawBoard(win, s, b);
+
+	if (showStats) {
+		char text[2 + 16][64];
+		const char* lines[2 + 16];
+		int count = 0;
+
+		if (f->unthrottled)
+			sprintf(text[count++], "Speed: unthrottled%s", f->paused ? " (paused)" : "");
+		else
+			sprintf(text[count++], "Speed: %gx%s", f->speed, f->paused ? " (paused)" : "");
+		sprintf(text[count++], "%.0lf ticks/s, %.0lf fps", f->ticksPerSecond, f->framesPerSecond);
+
+		for (int i = 0; nn && i < 16; i++)
+			sprintf(text[count++], "%d: %f", i, nn->outputs[0][i]);
+
+		for (int i = 0; i < count; i++)
+			lines[i] = text[i];
+		drawOverlay(win, lines, count);
+	}
+
+	SDL_RenderPresent(win->renderer);
+}
+
 /**
  * @brief This function initilises the game vars and plays it.
  * @param win - the game window and the renderer
@@ -17,17 +108,19 @@
  */
 int playHuman(renderWindow* win, snake* s, board* b) {
     initiliseSnakeAndBoard(s, b);
+	frameScheduler f;
 	SDL_Event e;
-	Uint32 time;
 	int keyDown = 0;
+	int showStats = 0;
 
+	//the thread sleeps until a key is pressed or the next tick is due
+	initialiseFrameScheduler(&f, 10);
 	while (s->alive) {
-		renderBoard(win, s, b);
-		time = SDL_GetTicks();
-
-		while (!SDL_TICKS_PASSED(SDL_GetTicks(), time+100) || SDL_PollEvent(&e) != 0) {
+		while (waitForFrameEvent(&f, &e)) {
 			if(e.type == SDL_QUIT) {
 				return -1;
+			} else if (handleFrameKeys(win, &f, &e, &showStats)) {
+				continue;
 			} else if (e.type == SDL_KEYUP) {
 				keyDown = 0;
 			} else if (e.type == SDL_KEYDOWN && !keyDown) {
@@ -42,118 +135,597 @@ int playHuman(renderWindow* win, snake* s, board* b) {
 				keyDown = 1;
 			}
 		}
-		updateSnake(s, b);
+
+		while (s->alive && nextTick(&f))
+			updateSnake(s, b);
+
+		if (nextRender(&f))
+			renderFrame(win, s, b, &f, showStats, NULL);
 	}
 	return 0;
 }
 
+/**
+ * @brief This function sets how long training games last without the snake eating
+ * @param start - ticks the snake has to find its first food
+ * @param perFood - ticks added each time it eats
+ * @return nothing
+ */
+void setStarvationBudget(int start, int perFood) {
+	startBudget = start;
+	foodBudget = perFood;
+}
+
+/**
+ * @brief This function gets how long training games last without the snake eating
+ * @param start - where the ticks the snake has to find its first food are stored
+ * @param perFood - where the ticks added each time it eats are stored
+ * @return nothing
+ */
+void getStarvationBudget(int* start, int* perFood) {
+	*start = startBudget;
+	*perFood = foodBudget;
+}
+
 /**
  * @brief This function initilises the game vars and plays it, used to train the nn
  * @param nn - the neural network to play the game
  * @param s - the snake
- * @param b - the board
+ * @param b - the board, the game carries on from its seed so set b->seed first for a repeatable game
+ * @param r - if not NULL, the game is recorded into this replay
+ * @param d - if not NULL, the games ticks are sampled into this dataset
  * @return nothing
  */
-int playCompTrain(neuralNetwork* nn, snake* s, board* b) {
-    initiliseSnakeAndBoard(s, b);
-	int ticksSinceAteFood = 50;
+int playCompTrain(neuralNetwork* nn, snake* s, board* b, replay* r, datasetRecorder* d) {
+	if (r)
+		startReplay(r, b->seed, r->header.generation);
+    initiliseSeededSnakeAndBoard(s, b, b->seed);
+	int ticksSinceAteFood = startBudget;
 	while (s->alive && ticksSinceAteFood > 0) {
 		if (s->x[0] == b->foodX & s->y[0] == b->foodY) 
-			ticksSinceAteFood += 150;
+			ticksSinceAteFood += foodBudget;
 
 		getInputs(nn, s, b);
 		frontPropegation(nn, 0);
 		s->move = getOutput(nn) - 1;		//nn outputs 0 for left, 1 for forward, 2 for right, one more than the game;
+		if (r)
+			recordMove(r, s->move);
+		if (d)
+			recordDatasetTick(d, nn->outputs[0], s->move + 1);
 
 		updateSnake(s, b);
 		ticksSinceAteFood--;
 	}
+	if (r)
+		finishReplay(r, s, b);
+	if (d)
+		finishDatasetGame(d, s);
 }
 
 /**
- * @brief This function initilises the game vars and plays it, shows the outputs of the
- * 		  nn to the user.
+ * @brief This function initilises the game vars and plays it, the nn's inputs can be shown
+ * 		  to the user in the stats overlay.
  * @param win - the window that will be rendered
  * @param nn - the neural network to play the game
+ * @param q - if not NULL, this quantised copy of nn chooses the moves instead
+ * @param p - if not NULL, this planner chooses the moves, looking ahead with nn
  * @param s - the snake
  * @param b - the board
- * @return nothing
+ * @param r - if not NULL, the game is recorded into this replay
+ * @return -1 if the user quits, 0 when the game ends
  */
-int playCompTest(renderWindow* win, neuralNetwork* nn, snake* s, board* b) {
-    initiliseSnakeAndBoard(s, b);
+int playCompTest(renderWindow* win, neuralNetwork* nn, quantisedNetwork* q, lookaheadPlanner* p, snake* s, board* b, replay* r) {
+	unsigned int seed = rand();
+	if (r)
+		startReplay(r, seed, -1);
+    initiliseSeededSnakeAndBoard(s, b, seed);
+	frameScheduler f;
 	SDL_Event e;
-	Uint32 time;
+	int showStats = 0;
 
+	initialiseFrameScheduler(&f, 50);
 	int ticksSinceAteFood = 100;
 	while (s->alive && ticksSinceAteFood > 0) {
-		renderBoard(win, s, b);
-		time = SDL_GetTicks();
+		while (waitForFrameEvent(&f, &e)) {
+			if(e.type == SDL_QUIT) 
+				return -1;
+			handleFrameKeys(win, &f, &e, &showStats);
+		}
 
-		if (s->x[0] == b->foodX & s->y[0] == b->foodY) 
-			ticksSinceAteFood += 150;
+		while (s->alive && ticksSinceAteFood > 0 && nextTick(&f)) {
+			if (s->x[0] == b->foodX & s->y[0] == b->foodY) 
+				ticksSinceAteFood += 150;
 
-		while (!SDL_TICKS_PASSED(SDL_GetTicks(), time+20) || SDL_PollEvent(&e) != 0) {
-			if(e.type == SDL_QUIT) 
+			if (p) {
+				s->move = planMove(p, s, b);
+			} else {
+				getInputs(nn, s, b);
+				if (q)
+					quantisedFrontPropegation(q, nn);
+				else
+					frontPropegation(nn, 0);
+				s->move = getOutput(nn) - 1;		//nn outputs 0 for left, 1 for forward, 2 for right, one more than the game;
+			}
+			if (r)
+				recordMove(r, s->move);
+
+			updateSnake(s, b);
+			ticksSinceAteFood--;
+		}
+
+		if (nextRender(&f))
+			renderFrame(win, s, b, &f, showStats, nn);
+	}
+	if (r)
+		finishReplay(r, s, b);
+	return 0;
+}
+
+/**
+ * @brief This function plays a recorded game back without the network. Up/down (or +/-) change
+ * 		  the speed, 0 runs it unthrottled, space pauses, left/right seek 10% back/forward,
+ * 		  home/end jump to the start/end and enter moves on to the next replay.
+ * @param win - the window that will be rendered
+ * @param r - the replay to show
+ * @param s - the snake
+ * @param b - the board
+ * @return -1 if the user quits, 0 when they move on
+ */
+int playReplay(renderWindow* win, replay* r, snake* s, board* b) {
+	int ticks = r->header.ticks;
+	int tick = 0;
+	int showStats = 0;
+	frameScheduler f;
+	SDL_Event e;
+
+	initialiseFrameScheduler(&f, 50);
+	seekReplay(r, s, b, 0);
+	while (1) {
+		int seekTo = tick;
+		while (waitForFrameEvent(&f, &e)) {
+			if (e.type == SDL_QUIT)
 				return -1;
+			if (e.type != SDL_KEYDOWN || handleFrameKeys(win, &f, &e, &showStats))
+				continue;
+
+			switch (e.key.keysym.sym) {
+			case SDLK_UP:
+				changeFrameSpeed(&f, 2);
+				break;
+			case SDLK_DOWN:
+				changeFrameSpeed(&f, 0.5);
+				break;
+			case SDLK_LEFT:
+				seekTo -= ticks/10 + 1;
+				break;
+			case SDLK_RIGHT:
+				seekTo += ticks/10 + 1;
+				break;
+			case SDLK_HOME:
+				seekTo = 0;
+				break;
+			case SDLK_END:
+				seekTo = ticks;
+				break;
+			case SDLK_RETURN:
+				return 0;
+			}
 		}
 
-		getInputs(nn, s, b);
+		//seeking is instant, the game is simply replayed from its seed without drawing
+		if (seekTo != tick) {
+			tick = seekTo < 0 ? 0 : seekTo > ticks ? ticks : seekTo;
+			free(s->x);
+			free(s->y);
+			seekReplay(r, s, b, tick);
+			redrawFrame(&f);
+		}
 
-		for (int i = 0; i < 16; i++) {
-			printf("%d: %f\n", i, nn->outputs[0][i]);
+		while (tick < ticks && nextTick(&f)) {
+			s->move = getReplayMove(r, tick++);
+			updateSnake(s, b);
 		}
-		printf("\n");
 
-		frontPropegation(nn, 0);
-		s->move = getOutput(nn) - 1;		//nn outputs 0 for left, 1 for forward, 2 for right, one more than the game;
+		//once the replay has finished, sleep until a key is pressed
+		if (tick == ticks && !f.paused)
+			toggleFramePause(&f);
 
-		updateSnake(s, b);
-        ticksSinceAteFood--;
+		if (nextRender(&f))
+			renderFrame(win, s, b, &f, showStats, NULL);
+	}
+}
+
+/**
+ * @brief This function shows the games a trainer publishes to a live feed, as they are published.
+ * 		  It waits for the trainer if it isn't running yet, and waits for the next one when it finishes.
+ * 		  The usual keys change the speed, pause and show the stats.
+ * @param win - the window that will be rendered
+ * @param name - the live feed
+ * @return -1 when the user quits
+ */
+int playLive(renderWindow* win, const char* name) {
+	liveFeed* feed = NULL;
+	liveFrame* frame = calloc(1, sizeof(liveFrame));
+	Uint64 lastAttach = 0;
+	int showStats = 0;
+	frameScheduler f;
+	SDL_Event e;
+
+	initialiseFrameScheduler(&f, 50);
+	while (1) {
+		while (waitForFrameEvent(&f, &e)) {
+			if (e.type == SDL_QUIT) {
+				if (feed)
+					detachLiveFeed(feed);
+				free(frame);
+				return -1;
+			}
+			handleFrameKeys(win, &f, &e, &showStats);
+		}
+
+		//there is nothing to attach to until training starts, so only look once a second
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (feed == NULL && now - lastAttach >= SDL_GetPerformanceFrequency()) {
+			lastAttach = now;
+			if ((feed = attachLiveFeed(name)) != NULL) {
+				printf("Attached to %s\n", name);
+				redrawFrame(&f);
+			}
+		}
+
+		int waiting = 1;
+		while (nextTick(&f)) {
+			if (feed && readLiveFrame(feed, frame)) {
+				waiting = 0;
+				continue;
+			}
+			if (feed && !liveFeedAlive(feed)) {
+				printf("Training finished, detached from %s\n", name);
+				detachLiveFeed(feed);
+				feed = NULL;
+			}
+			break;
+		}
+
+		//unthrottled with nothing to show, sleep for a frame rather than polling the feed flat out
+		if (waiting && f.unthrottled && !f.paused)
+			SDL_WaitEventTimeout(NULL, 1000 / FRAME_MAX_FPS);
+
+		if (nextRender(&f)) {
+			int width, height;
+			SDL_GetRendererOutputSize(win->renderer, &width, &height);
+			SDL_Rect tile = {0, 0, width, height};
+			boardSnapshot* snapshot = &frame->snapshot;
+			char temp[256];
+
+			SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
+			SDL_RenderClear(win->renderer);
+			drawSnapshots(win, &snapshot, &tile, 1);
+
+			if (feed == NULL) {
+				sprintf(temp, "Waiting for training on %s", name);
+				drawText(win, temp, 10, 10);
+			} else if (snapshot->width) {
+				sprintf(temp, "Score: %d", snapshot->score);
+				drawText(win, temp, 10, 10);
+				sprintf(temp, "Generation: %d", frame->generation);
+				drawText(win, temp, width - 200, 10);
+			}
+
+			if (showStats) {
+				char text[3][64];
+				const char* lines[3];
+				if (f.unthrottled)
+					sprintf(text[0], "Speed: unthrottled%s", f.paused ? " (paused)" : "");
+				else
+					sprintf(text[0], "Speed: %gx%s", f.speed, f.paused ? " (paused)" : "");
+				sprintf(text[1], "%.0lf ticks/s, %.0lf fps", f.ticksPerSecond, f.framesPerSecond);
+				sprintf(text[2], "%llu frames skipped", feed ? (unsigned long long)feed->skipped : 0ULL);
+				for (int i = 0; i < 3; i++)
+					lines[i] = text[i];
+				drawOverlay(win, lines, 3);
+			}
+
+			SDL_RenderPresent(win->renderer);
+		}
 	}
-	return 0;
 }
 
 int main(int argc, char** argv) {
 	srand(time(NULL));
 
+	//--board NxN, --layout and --record work with every command, they are taken out so the commands see their usual arguments
+	const char* recordPath = NULL;
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "--board") && strcmp(argv[i], "--layout") && strcmp(argv[i], "--record")) || i+1 >= argc)
+			continue;
+
+		if (!strcmp(argv[i], "--record")) {
+			recordPath = argv[i+1];
+		} else if (!strcmp(argv[i], "--board")) {
+			int width, height;
+			int read = sscanf(argv[i+1], "%dx%d", &width, &height);
+			if (read >= 1)
+				setBoardSize(width, read == 2 ? height : width);
+		} else {
+			//getInputs fills 16 inputs and the game takes one of 3 moves
+			int layout[NETWORK_MAX_LAYERS];
+			int networkSize = readNetworkLayout(argv[i+1], layout);
+			if (!networkSize)
+				return 1;
+			if (!playableLayout(layout, networkSize)) {
+				printf("A network layout must start with %d inputs and end with %d outputs\n", NETWORK_INPUTS, NETWORK_OUTPUTS);
+				return 1;
+			}
+			setDefaultLayout(networkSize, layout);
+		}
+		for (int j = i; j + 2 <= argc; j++)
+			argv[j] = argv[j+2];
+		argc -= 2;
+		i--;
+	}
+
 	if (argc < 2) {
 		printf("Enter a valid command:\n");
 		printf("Play:\t\tplay\n");
-		printf("Train:\t\ttrain\n");
-		printf("Test:\t\ttest\n");
+		printf("Train:\t\ttrain [--dataset file] [--sample rate] [--compress] [--live [name]]\n");
+		printf("\t\t      [--export directory] [--export-format png|raw] [--export-cell pixels]\n");
+		printf("\t\t      [--curriculum [size:startBudget:foodBudget:fitness,...]] [--target score]\n");
+		printf("\t\t      [--diversity [file]] [--memetic [generations]] [--es [pairs]] [--threads n]\n");
+		printf("\t\t      [--outcomes file] [--generations n]\n");
+		printf("Dataset:\tdataset file\n");
+		printf("Outcomes:\toutcomes file\n");
+		printf("Test:\t\ttest [brain] [8|16|quantisedBrain]\n");
+		printf("Replay:\t\ttest replayFile [index]\n");
+		printf("Plan:\t\tplan [brain] [milliseconds] [games [seed]], with games the planner is compared without a window\n");
+		printf("Spectate:\tspectate directory|replayFile|brain [boards]\n");
+		printf("Watch:\t\twatch [name]\n");
+		printf("Export:\t\texport replayFile directory [png|raw] [pixels]\n");
+		printf("Quantise:\tquantise brain 8|16 [output]\n");
+		printf("Serve:\t\tdaemon socket brain [brain...]\n");
+		printf("Evaluate:\tevaluate [directory] [games] [seed]\n");
+		printf("Sweep:\t\tsweep spec [threads]\n");
+		printf("Any command:\t--board width[xheight], the board size in cells, from %d to %d\n", BOARD_MIN_SIZE, BOARD_MAX_SIZE);
+		printf("\t\t--layout 16,...,3|file, the layout of new networks, or the first line of a file such as a brain\n");
+		printf("\t\t--record file, test and plan append every game watched to this replay file\n");
 	}
-	renderWindow* win = malloc(sizeof(renderWindow));
+	renderWindow* win = calloc(1, sizeof(renderWindow));
 	snake* s = malloc(sizeof(snake));
 	board* b = malloc(sizeof(board));
 
 	if (!strcmp(argv[1], "train")) {
-		neuralNetwork** population = calloc(populationSize, sizeof(neuralNetwork*));
-		initiliseTrainingData(population);
-		randomisePopulation(population);
-		trainNetwork(population, 100);
+		trainingOptions options;
+		curriculum stages;
+		initialiseTrainingOptions(&options);
+		for (int i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "--dataset") && i+1 < argc)
+				options.datasetPath = argv[++i];
+			else if (!strcmp(argv[i], "--sample") && i+1 < argc)
+				options.datasetSampleRate = atof(argv[++i]);
+			else if (!strcmp(argv[i], "--compress"))
+				options.datasetCompression = 1;
+			else if (!strcmp(argv[i], "--live"))
+				options.liveFeedName = i+1 < argc && argv[i+1][0] == '/' ? argv[++i] : LIVE_FEED_NAME;
+			else if (!strcmp(argv[i], "--export") && i+1 < argc)
+				options.exportDirectory = argv[++i];
+			else if (!strcmp(argv[i], "--export-format") && i+1 < argc)
+				options.exportFormat = !strcmp(argv[++i], "raw") ? EXPORT_RAW : EXPORT_PNG;
+			else if (!strcmp(argv[i], "--export-cell") && i+1 < argc)
+				options.exportCellSize = atoi(argv[++i]);
+			else if (!strcmp(argv[i], "--diversity")) {
+				options.diversity = 1;
+				if (i+1 < argc && strncmp(argv[i+1], "--", 2))
+					options.diversityLog = argv[++i];
+			}
+			else if (!strcmp(argv[i], "--memetic"))
+				options.memeticInterval = i+1 < argc && strncmp(argv[i+1], "--", 2) ? atoi(argv[++i]) : MEMETIC_INTERVAL;
+			else if (!strcmp(argv[i], "--es"))
+				options.esPairs = i+1 < argc && strncmp(argv[i+1], "--", 2) ? atoi(argv[++i]) : ES_PAIRS;
+			else if (!strcmp(argv[i], "--generations") && i+1 < argc)
+				options.generations = atoi(argv[++i]);
+			else if (!strcmp(argv[i], "--threads") && i+1 < argc)
+				options.threads = atoi(argv[++i]);
+			else if (!strcmp(argv[i], "--outcomes") && i+1 < argc)
+				options.outcomeLogPath = argv[++i];
+			else if (!strcmp(argv[i], "--target") && i+1 < argc)
+				options.targetScore = atoi(argv[++i]);
+			else if (!strcmp(argv[i], "--curriculum")) {
+				options.curriculum = &stages;
+				if (i+1 < argc && strncmp(argv[i+1], "--", 2)) {
+					if (!parseCurriculum(&stages, argv[++i]))
+						return 1;
+				} else {
+					initialiseCurriculum(&stages);
+				}
+			}
+		}
+
+		//evolution strategies has no population, so the options that work on one can't be used with it
+		if (options.esPairs > 0 && (options.datasetPath || options.liveFeedName || options.exportDirectory ||
+				options.curriculum || options.diversity || options.memeticInterval)) {
+			printf("--es can't be used with --dataset, --live, --export, --curriculum, --diversity or --memetic\n");
+			return 1;
+		}
+
+		if (options.esPairs > 0) {
+			if (!trainEvolutionStrategies(options.generations, &options))
+				return 1;
+		} else {
+			neuralNetwork** population = calloc(populationSize, sizeof(neuralNetwork*));
+			initiliseTrainingData(population);
+			randomisePopulation(population);
+			trainNetwork(population, options.generations, &options);
+		}
 		//save population
 	}
 
-	else if (!strcmp(argv[1], "play") || !strcmp(argv[1], "test")) {
+	else if (!strcmp(argv[1], "quantise")) {
+		if (argc < 4) {
+			printf("Usage: quantise brain 8|16 [output]\n");
+			return 1;
+		}
+
+		neuralNetwork* nn = malloc(sizeof(neuralNetwork));
+		quantisedNetwork* q = malloc(sizeof(quantisedNetwork));
+		initialiseNetworkBrain(nn);
+		loadBrain(nn, argv[2]);
+		if (!quantiseNetwork(nn, q, atoi(argv[3])))
+			return 1;
+
+		quantisedAgreement(nn, q, 1000);
+		if (argc > 4)
+			saveQuantisedBrain(q, argv[4]);
+
+		destroyQuantisedNetwork(q);
+		destroyBrainData(nn);
+		free(q);
+		free(nn);
+	}
+
+	else if (!strcmp(argv[1], "export")) {
+		if (argc < 4) {
+			printf("Usage: export replayFile directory [png|raw] [pixels]\n");
+			return 1;
+		}
+
+		exportFormat format = argc > 4 && !strcmp(argv[4], "raw") ? EXPORT_RAW : EXPORT_PNG;
+		if (!exportReplayFile(argv[2], argv[3], format, argc > 5 ? atoi(argv[5]) : EXPORT_CELL_SIZE))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "dataset")) {
+		if (argc < 3 || !summariseDataset(argv[2]))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "outcomes")) {
+		if (argc < 3 || !summariseOutcomes(argv[2]))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "evaluate")) {
+		const char* directory = argc > 2 ? argv[2] : "brains";
+		int games = argc > 3 ? atoi(argv[3]) : 100;
+		unsigned int seed = argc > 4 ? strtoul(argv[4], NULL, 10) : 1;
+
+		if (games < 1 || !evaluateBrains(directory, games, seed, 0))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "sweep")) {
+		if (argc < 3) {
+			printf("Usage: sweep spec [threads]\n");
+			return 1;
+		}
+
+		if (!runSweep(argv[2], argc > 3 ? atoi(argv[3]) : 0))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "daemon")) {
+		if (argc < 4) {
+			printf("Usage: daemon socket brain [brain...]\n");
+			return 1;
+		}
+
+		if (!runInferenceDaemon(argv[2], (const char**)&argv[3], argc - 3))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "plan") && argc > 4) {
+		neuralNetwork* nn = malloc(sizeof(neuralNetwork));
+		initialiseNetworkBrain(nn);
+		loadBrain(nn, argv[2]);
+		int games = atoi(argv[4]);
+		if (games < 1 || !comparePlanner(nn, games, argc > 5 ? strtoul(argv[5], NULL, 10) : 1, atoi(argv[3])))
+			return 1;
+	}
+
+	else if (!strcmp(argv[1], "play") || !strcmp(argv[1], "test") || !strcmp(argv[1], "plan") || !strcmp(argv[1], "spectate") || !strcmp(argv[1], "watch")) {
+		int spectating = !strcmp(argv[1], "spectate");
 		if (!initiliseSDL()) {
 			printf("SDL Initilisation Failed");
 			return 1;
 		}
 
-		if (!initiliseWindow(win, "snake", HEIGHT, WIDTH)) {
+		if (!initiliseWindow(win, "snake", spectating ? SPECTATOR_WINDOW : HEIGHT, spectating ? SPECTATOR_WINDOW : WIDTH)) {
 			printf("Window Initilisation Failed");
 			return 1;
 		}
 
-		if (!strcmp(argv[1], "play")) {
+		if (spectating) {
+			if (!runSpectator(win, argc > 2 ? argv[2] : "brains", argc > 3 ? atoi(argv[3]) : 16))
+				return 1;
+		}
+
+		else if (!strcmp(argv[1], "watch")) {
+			playLive(win, argc > 2 ? argv[2] : LIVE_FEED_NAME);
+		}
+
+		else if (!strcmp(argv[1], "play")) {
 			while(playHuman(win, s, b) != -1);
 		}
 
+		else if (!strcmp(argv[1], "test") && argc > 2 && countReplays(argv[2])) {
+			replay r;
+			initialiseReplay(&r);
+			int count = countReplays(argv[2]);
+			int first = argc > 3 ? atoi(argv[3]) : 0;
+			int last = argc > 3 ? first + 1 : count;
+
+			for (int i = first; i < last && loadReplay(&r, argv[2], i); i++) {
+				printf("Replay %d: generation %d, score %d, %u ticks\n", i, r.header.generation, r.header.score, r.header.ticks);
+				if (playReplay(win, &r, s, b) == -1)
+					break;
+			}
+			destroyReplay(&r);
+		}
+
+		else if (!strcmp(argv[1], "plan")) {
+			neuralNetwork* nn = malloc(sizeof(neuralNetwork));
+			lookaheadPlanner p;
+			initialiseNetworkBrain(nn);
+			loadBrain(nn, argc > 2 ? argv[2] : "brains/Generation_132");
+			initialisePlanner(&p, nn, argc > 3 ? atoi(argv[3]) : PLAN_BUDGET);
+
+			//games are only kept when --record is given
+			replay r;
+			initialiseReplay(&r);
+			while(playCompTest(win, nn, NULL, &p, s, b, recordPath ? &r : NULL) != -1)
+				if (recordPath)
+					appendReplay(&r, recordPath);
+			destroyReplay(&r);
+			destroyPlanner(&p);
+		}
+
 		else if (!strcmp(argv[1], "test")) {
 			neuralNetwork* nn = malloc(sizeof(neuralNetwork));
+			quantisedNetwork* q = NULL;
 			initialiseNetworkBrain(nn);
-			loadBrain(nn, "brains/Generation_132");
-			while(playCompTest(win, nn, s, b) != -1);
+			loadBrain(nn, argc > 2 ? argv[2] : "brains/Generation_132");
+
+			//8 or 16 quantises the brain now, anything else is a brain saved by quantise
+			if (argc > 3) {
+				q = malloc(sizeof(quantisedNetwork));
+				if (!strcmp(argv[3], "8") || !strcmp(argv[3], "16")) {
+					if (!quantiseNetwork(nn, q, atoi(argv[3])))
+						return 1;
+				}
+				else if (!loadQuantisedBrain(q, argv[3]))
+					return 1;
+				else if (q->networkSize != nn->networkSize || memcmp(q->networkLayout, nn->networkLayout, nn->networkSize * sizeof(int))) {
+					printf("%s was not quantised from a network with the layout of %s\n", argv[3], argv[2]);
+					return 1;
+				}
+				quantisedAgreement(nn, q, 100);
+			}
+			//with --record every game watched is kept, so it can be replayed later
+			replay r;
+			initialiseReplay(&r);
+			while(playCompTest(win, nn, q, NULL, s, b, recordPath ? &r : NULL) != -1)
+				if (recordPath)
+					appendReplay(&r, recordPath);
+			destroyReplay(&r);
 		}
 	}
 
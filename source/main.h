@@ -3,8 +3,17 @@
 #include "snakeGame.h"
 #include "snakeGraphics.h"
 #include "neuralNetworkShell.h"
+#include "quantisedNetwork.h"
+#include "replay.h"
+#include "datasetRecorder.h"
+#include "liveFeed.h"
 #include "neuralNetworkData.h"
+#include "planner.h"
 
+void setStarvationBudget(int, int);
+void getStarvationBudget(int*, int*);
 int playHuman(renderWindow*, snake*, board*);
-int playCompTrain(neuralNetwork*, snake*, board*);
-int playCompTest(renderWindow*, neuralNetwork*, snake*, board*);
\ No newline at end of file
+int playCompTrain(neuralNetwork*, snake*, board*, replay*, datasetRecorder*);
+int playCompTest(renderWindow*, neuralNetwork*, quantisedNetwork*, lookaheadPlanner*, snake*, board*, replay*);
+int playReplay(renderWindow*, replay*, snake*, board*);
+int playLive(renderWindow*, const char*);
\ No newline at end of file
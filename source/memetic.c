@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "memetic.h"
+#include "neuralNetworkShell.h"
+#include "geneticNeuralNetwork.h"
+#include "snakeGame.h"
+#include "replay.h"
+#include "main.h"
+
+/**
+ * @brief This function finds the best networks, best first
+ * @param fitness - the fitnesses of each member of the population
+ * @param count - the number of networks
+ * @param elites - where the indices of the MEMETIC_ELITES best are stored
+ * @return the number of elites found, fewer than MEMETIC_ELITES if the population is smaller
+ */
+static int findElites(double* fitness, int count, int* elites) {
+	int found = 0;
+	for (int i = 0; i < count; i++) {
+		int j = found < MEMETIC_ELITES ? found++ : MEMETIC_ELITES;
+		if (j == MEMETIC_ELITES && fitness[i] <= fitness[elites[j-1]])
+			continue;
+		if (j == MEMETIC_ELITES)
+			j--;
+		for (; j > 0 && fitness[elites[j-1]] < fitness[i]; j--)
+			elites[j] = elites[j-1];
+		elites[j] = i;
+	}
+	return found;
+}
+
+/**
+ * @brief This function replays a finished game and keeps every tick before the last food eaten
+ * @param r - the game
+ * @param data - where the samples are added
+ * @param inputs - the number of network inputs
+ * @param outputs - the number of network outputs
+ * @return nothing
+ */
+static void gatherSamples(replay* r, memeticData* data, int inputs, int outputs) {
+	snake s;
+	board b;
+	int kept = data->count;					//samples before this are on the way to a food that was eaten
+	seekReplay(r, &s, &b, 0);
+	for (int i = 0; i < (int)r->header.ticks && data->count < MEMETIC_MAX_SAMPLES; i++) {
+		double* target = &data->targets[(size_t)data->count * outputs];
+		senseBoard(&s, &b, &data->inputs[(size_t)data->count * inputs]);
+		s.move = getReplayMove(r, i);
+		for (int j = 0; j < outputs; j++)
+			target[j] = j == s.move + 1;
+		data->count++;
+
+		int score = s.score;
+		updateSnake(&s, &b);
+		if (s.score > score)
+			kept = data->count;
+	}
+	data->count = kept;
+	free(s.x);
+	free(s.y);
+}
+
+/**
+ * @brief This function plays a network on a set of games
+ * @param nn - the network
+ * @param seeds - the games
+ * @return the mean fitness of the games
+ */
+static double trialFitness(neuralNetwork* nn, unsigned int* seeds) {
+	snake s;
+	board b;
+	double fitness = 0;
+	for (int i = 0; i < MEMETIC_TRIALS; i++) {
+		b.seed = seeds[i];
+		playCompTrain(nn, &s, &b, NULL, NULL);
+		fitness += gameFitness(&s, FITNESS_EXPONENTIAL);
+		free(s.x);
+		free(s.y);
+	}
+	return fitness / MEMETIC_TRIALS;
+}
+
+/**
+ * @brief This function fine tunes the best networks of a generation with gradient descent on
+ * 		  the moves the best one made on its way to food, see memetic.h
+ * @param population - the collection of networks, the elites are overwritten if they improve
+ * @param fitness - the fitnesses of each member of the population
+ * @param count - the number of networks
+ * @param generation - the generation, for the report
+ * @return the number of games played
+ */
+int memeticStage(neuralNetwork** population, double* fitness, int count, int generation) {
+	int elites[MEMETIC_ELITES];
+	int eliteCount = findElites(fitness, count, elites);
+	neuralNetwork* best = population[elites[0]];
+	int inputs = best->networkLayout[0];
+	int outputs = best->networkLayout[best->networkSize-1];
+
+	memeticData data;
+	data.inputs = malloc((size_t)MEMETIC_MAX_SAMPLES * inputs * sizeof(double));
+	data.targets = malloc((size_t)MEMETIC_MAX_SAMPLES * outputs * sizeof(double));
+	data.count = 0;
+
+	snake s;
+	board b;
+	replay r;
+	initialiseReplay(&r);
+	for (int i = 0; i < MEMETIC_GAMES; i++) {
+		b.seed = rand();
+		playCompTrain(best, &s, &b, &r, NULL);
+		free(s.x);
+		free(s.y);
+		gatherSamples(&r, &data, inputs, outputs);
+	}
+	destroyReplay(&r);
+
+	int games = MEMETIC_GAMES;
+	int improved = 0;
+	if (data.count >= MEMETIC_BATCH) {
+		unsigned int seeds[MEMETIC_TRIALS];
+		for (int i = 0; i < MEMETIC_TRIALS; i++)
+			seeds[i] = rand();
+
+		double* batchInputs = malloc((size_t)MEMETIC_BATCH * inputs * sizeof(double));
+		double* batchTargets = malloc((size_t)MEMETIC_BATCH * outputs * sizeof(double));
+		neuralNetwork tuned = {0};
+		initialiseNetworkBrain(&tuned);
+
+		for (int e = 0; e < eliteCount; e++) {
+			neuralNetwork* elite = population[elites[e]];
+			double bestFitness = trialFitness(elite, seeds);
+			int tunedBetter = 0;
+			deepCopy(elite, &tuned);
+			for (int step = 1; step <= MEMETIC_STEPS; step++) {
+				for (int j = 0; j < MEMETIC_BATCH; j++) {
+					int sample = rand() % data.count;
+					memcpy(&batchInputs[j * inputs], &data.inputs[(size_t)sample * inputs], inputs * sizeof(double));
+					memcpy(&batchTargets[j * outputs], &data.targets[(size_t)sample * outputs], outputs * sizeof(double));
+				}
+				batchBackPropegation(&tuned, batchInputs, batchTargets, MEMETIC_BATCH, LOSS_CROSS_ENTROPY, MEMETIC_LEARNING_RATE);
+
+				//the elites fitness was from other games, so both are played on the same ones
+				if (step >= MEMETIC_FIRST_CHECK && (step & (step - 1)) == 0) {
+					double tunedFitness = trialFitness(&tuned, seeds);
+					games += MEMETIC_TRIALS;
+					if (tunedFitness > bestFitness) {
+						bestFitness = tunedFitness;
+						deepCopy(&tuned, elite);
+						tunedBetter = 1;
+					}
+				}
+			}
+			improved += tunedBetter;
+			games += MEMETIC_TRIALS;
+		}
+
+		destroyBrainData(&tuned);
+		free(batchInputs);
+		free(batchTargets);
+	}
+
+	printf("Memetic stage for Generation%d: %d samples, %d of %d elites improved\n", generation, data.count, improved, eliteCount);
+	free(data.inputs);
+	free(data.targets);
+	return games;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "neuralNetworkShell.h"
+
+#define MEMETIC_INTERVAL 5				//generations between stages, when --memetic is given no value
+#define MEMETIC_ELITES 4				//the best networks that are fine tuned
+#define MEMETIC_GAMES 16				//games the best network plays to gather the training data
+#define MEMETIC_STEPS 256				//gradient descent steps per elite
+#define MEMETIC_FIRST_CHECK 16			//steps before the tuned elite is first tried, then every time the steps double
+#define MEMETIC_BATCH 64				//ticks in each step
+#define MEMETIC_LEARNING_RATE 0.01
+#define MEMETIC_TRIALS 10				//games the tuned and untuned elite are compared on
+#define MEMETIC_MAX_SAMPLES 65536
+
+/*
+	Every few generations the best network plays MEMETIC_GAMES games, and every tick on the way to
+	a food it ate becomes a sample, its inputs and the move it made. Ticks after the last food are
+	dropped, as they led to the snake dying or starving. Each elite then takes up to MEMETIC_STEPS
+	steps of batchBackPropegation, with a cross entropy loss, towards making those moves. Tuning
+	helps some networks and hurts others, so the tuned elite is tried on MEMETIC_TRIALS games after
+	MEMETIC_FIRST_CHECK steps and every time the steps double, and the best that beats the untuned
+	elite on the same games replaces it in the population.
+*/
+struct memeticData {
+	double* inputs;						//MEMETIC_MAX_SAMPLES rows of networkLayout[0]
+	double* targets;					//MEMETIC_MAX_SAMPLES rows of networkLayout[networkSize-1], 1 for the move made
+	int count;
+};
+typedef struct memeticData memeticData;
+
+int memeticStage(neuralNetwork**, double*, int, int);
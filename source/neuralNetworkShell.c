@@ -1,10 +1,104 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <stdarg.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "neuralNetworkShell.h"
 
+//the layout new networks are given, can be changed from the command line
+static int defaultSize = 3;
+static int defaultLayout[NETWORK_MAX_LAYERS] = {16, 9, 3};
+
+/*
+	Every layer is passed forwards by a layer kernel. The shapes below, the standard 16,9,3 network
+	and the hidden widths most often tried with it, get a kernel of their own where the sizes are
+	constants, so the loops are unrolled completely and the sums stay in registers. Any other shape
+	uses denseLayerBlocked. All of them add up each output in the same order as the original loop,
+	so a network plays exactly the same whichever kernel it gets.
+*/
+#define SPECIALISED_LAYERS(X) \
+	X(16, 9) X(9, 9) X(9, 3) \
+	X(16, 8) X(8, 8) X(8, 3) \
+	X(16, 12) X(12, 12) X(12, 3) \
+	X(16, 16) X(16, 3) \
+	X(16, 24) X(24, 24) X(24, 3) \
+	X(16, 32) X(32, 32) X(32, 3)
+
+#define DENSE_LAYER_KERNEL(IN, OUT) \
+static void denseLayer##IN##x##OUT(double** weights, const double* biases, const double* input, double* output, int in, int out) { \
+	(void)in; (void)out;		/* the shape is fixed, they are only there to match layerKernel */ \
+	double sum[OUT] = {0}; \
+	_Pragma("GCC unroll 32") \
+	for (int k = 0; k < IN; k++) { \
+		const double* w = weights[k]; \
+		_Pragma("GCC unroll 32") \
+		for (int j = 0; j < OUT; j++) \
+			sum[j] += input[k] * w[j]; \
+	} \
+	for (int j = 0; j < OUT; j++) { \
+		double x = sum[j] + biases[j]; \
+		output[j] = crelu(x); \
+	} \
+}
+
+SPECIALISED_LAYERS(DENSE_LAYER_KERNEL)
+
+/**
+ * @brief This function passes one layer of any shape forwards, LAYER_BLOCK outputs at a time so
+ * 		  their sums are kept in registers while the inputs are gone through
+ * @param weights - the layers weights, weights[k] is the row from input k
+ * @param biases - the layers biases
+ * @param input - the outputs of the layer before
+ * @param output - where the layers outputs are written
+ * @param in - the number of inputs
+ * @param out - the number of outputs
+ * @return nothing
+ */
+static void denseLayerBlocked(double** weights, const double* biases, const double* input, double* output, int in, int out) {
+	int j = 0;
+	for (; j + LAYER_BLOCK <= out; j += LAYER_BLOCK) {
+		double sum[LAYER_BLOCK] = {0};
+		for (int k = 0; k < in; k++) {
+			const double* w = weights[k] + j;
+			for (int l = 0; l < LAYER_BLOCK; l++)
+				sum[l] += input[k] * w[l];
+		}
+		for (int l = 0; l < LAYER_BLOCK; l++) {
+			double x = sum[l] + biases[j+l];
+			output[j+l] = crelu(x);
+		}
+	}
+
+	for (; j < out; j++) {
+		double sum = 0.0;
+		for (int k = 0; k < in; k++)
+			sum += input[k] * weights[k][j];
+		double x = sum + biases[j];
+		output[j] = crelu(x);
+	}
+}
+
+/**
+ * @brief This function picks the kernel for a layer
+ * @param in - the number of inputs
+ * @param out - the number of outputs
+ * @return the layers specialised kernel if it has one, otherwise denseLayerBlocked
+ */
+static layerKernel selectLayerKernel(int in, int out) {
+#define MATCH_LAYER_KERNEL(IN, OUT) \
+	if (in == IN && out == OUT) \
+		return denseLayer##IN##x##OUT;
+	SPECIALISED_LAYERS(MATCH_LAYER_KERNEL)
+#undef MATCH_LAYER_KERNEL
+	return denseLayerBlocked;
+}
+
 /**
  * @brief This function sets the structure of the neural network struct passed in.
  * @param nn - the neural network whos structure will be set
@@ -27,13 +121,92 @@ void setNetworkLayout(neuralNetwork* nn, int networkSize, ...) {
 }
 
 /**
- * @brief This function creates, empty, a new network "brain"
+ * @brief This function sets the layout initialiseNetworkBrain gives new networks
+ * @param networkSize - the number of layers, including input and output layers
+ * @param layout - the size of each layer
+ * @return nothing
+ */
+void setDefaultLayout(int networkSize, const int* layout) {
+	defaultSize = networkSize;
+	memcpy(defaultLayout, layout, networkSize * sizeof(int));
+}
+
+/**
+ * @brief This function checks a layout can play the game, every layer is a sensible size, the
+ * 		  first takes the inputs getInputs fills and the last has one output per move
+ * @param layout - the size of each layer
+ * @param networkSize - the number of layers
+ * @return 1 if it can, 0 otherwise
+ */
+int playableLayout(const int* layout, int networkSize) {
+	if (networkSize < 2 || networkSize > NETWORK_MAX_LAYERS)
+		return 0;
+	for (int i = 0; i < networkSize; i++)
+		if (layout[i] < 1 || layout[i] > NETWORK_MAX_WIDTH)
+			return 0;
+	return layout[0] == NETWORK_INPUTS && layout[networkSize-1] == NETWORK_OUTPUTS;
+}
+
+/**
+ * @brief This function reads a network layout, either written out, e.g. 16,24,24,3, or from the
+ * 		  first line of a file. A saved brain starts with its layout, so it can be used as the file.
+ * @param text - the layout or the files path
+ * @param layout - where the size of each layer is stored, room for NETWORK_MAX_LAYERS
+ * @return the number of layers, or 0 if the layout could not be read
+ */
+int readNetworkLayout(const char* text, int* layout) {
+	char line[4096];
+	snprintf(line, sizeof(line), "%s", text);
+
+	if (!isdigit((unsigned char)text[0])) {
+		FILE* f = fopen(text, "r");
+		if (f == NULL || fgets(line, sizeof(line), f) == NULL) {
+			if (f)
+				fclose(f);
+			printf("Could not read a network layout from %s\n", text);
+			return 0;
+		}
+		fclose(f);
+	}
+
+	int networkSize = 0;
+	for (char* token = strtok(line, ", \t\r\n"); token; token = strtok(NULL, ", \t\r\n")) {
+		char* e;
+		long size = strtol(token, &e, 10);
+		if (*e || size < 1 || size > NETWORK_MAX_WIDTH || networkSize == NETWORK_MAX_LAYERS) {
+			printf("%s is not a network layout\n", text);
+			return 0;
+		}
+		layout[networkSize++] = size;
+	}
+
+	if (networkSize < 2) {
+		printf("%s is not a network layout\n", text);
+		return 0;
+	}
+	return networkSize;
+}
+
+/**
+ * @brief This function creates, empty, a new network "brain" with the layout set by setDefaultLayout,
+ * 		  16,9,3 unless it was changed
  * @param nn - this stores the neural networks data points
  * @return nothing
  */
 void initialiseNetworkBrain(neuralNetwork* nn) {
-	setNetworkLayout(nn, 3, 16, 9, 3);
+	nn->networkSize = defaultSize;
+	nn->networkLayout = calloc(defaultSize, sizeof(int));
+	memcpy(nn->networkLayout, defaultLayout, defaultSize * sizeof(int));
+	allocateNetworkBrain(nn);
+}
 
+/**
+ * @brief This function allocates the, empty, weights, biases and outputs for the layout already
+ * 		  stored in the network
+ * @param nn - this stores the neural networks data points, its layout must be set
+ * @return nothing
+ */
+void allocateNetworkBrain(neuralNetwork* nn) {
 	nn->weights = calloc(nn->networkSize - 1, sizeof(double**));
     nn->biases = calloc(nn->networkSize - 1, sizeof(double*));
 
@@ -48,6 +221,10 @@ void initialiseNetworkBrain(neuralNetwork* nn) {
 	nn->outputs = calloc(nn->networkSize, sizeof(double*));
 	for (int i = 0; i < nn->networkSize; i++) 
 		nn->outputs[i] = calloc(nn->networkLayout[i], sizeof(double));
+
+	nn->kernels = calloc(nn->networkSize - 1, sizeof(layerKernel));
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		nn->kernels[i] = selectLayerKernel(nn->networkLayout[i], nn->networkLayout[i+1]);
 }
 
 /**
@@ -69,6 +246,7 @@ void destroyBrainData(neuralNetwork* nn) {
         free(nn->outputs[i]);
     free(nn->outputs);
 
+	free(nn->kernels);
 	free(nn->networkLayout);
 }
 
@@ -128,14 +306,7 @@ void assignInputs(neuralNetwork* nn, double* inputs) {
  */
 void frontPropegation(neuralNetwork* nn, int normilise) {
 	for (int i = 0; i < nn->networkSize - 1; i++) {
-		for (int j = 0; j < nn->networkLayout[i+1]; j++) {
-			nn->outputs[i+1][j] = 0.0;
-			for (int k = 0; k < nn->networkLayout[i]; k++) 
-				nn->outputs[i+1][j] += nn->outputs[i][k] * nn->weights[i][k][j];
-
-			nn->outputs[i+1][j] += nn->biases[i][j];
-			nn->outputs[i+1][j] = crelu(nn->outputs[i+1][j]);
-		}
+		nn->kernels[i](nn->weights[i], nn->biases[i], nn->outputs[i], nn->outputs[i+1], nn->networkLayout[i], nn->networkLayout[i+1]);
 
 		//normilse the output data
         if (normilise) {
@@ -150,6 +321,178 @@ void frontPropegation(neuralNetwork* nn, int normilise) {
 	}
 }
 
+/**
+ * @brief This function passes a whole batch of inputs through the network at once, so each
+ *        weight is loaded once per batch instead of once per input. nn->outputs is not touched.
+ * @param nn - this stores all of the networks data points
+ * @param inputs - batchSize rows of networkLayout[0] inputs
+ * @param outputs - batchSize rows of networkLayout[networkSize-1] outputs, written to
+ * @param batchSize - the number of rows in the batch
+ * @return nothing
+ */
+void batchFrontPropegation(neuralNetwork* nn, const double* inputs, double* outputs, int batchSize) {
+	int widest = 0;
+	for (int i = 0; i < nn->networkSize; i++)
+		if (nn->networkLayout[i] > widest)
+			widest = nn->networkLayout[i];
+
+	double* current = malloc((size_t)batchSize * widest * sizeof(double));
+	double* next = malloc((size_t)batchSize * widest * sizeof(double));
+	memcpy(current, inputs, (size_t)batchSize * nn->networkLayout[0] * sizeof(double));
+
+	for (int i = 0; i < nn->networkSize - 1; i++) {
+		int in = nn->networkLayout[i];
+		int out = nn->networkLayout[i+1];
+		double* layerOutputs = i == nn->networkSize - 2 ? outputs : next;
+
+		for (int b = 0; b < batchSize; b++) {
+			double* row = &layerOutputs[b * out];
+			for (int j = 0; j < out; j++)
+				row[j] = 0.0;
+
+			//weights[i][k] is contiguous over the output neurons, so the inner loop vectorises
+			for (int k = 0; k < in; k++) {
+				double input = current[b * in + k];
+				const double* w = nn->weights[i][k];
+				for (int j = 0; j < out; j++)
+					row[j] += input * w[j];
+			}
+
+			for (int j = 0; j < out; j++) {
+				row[j] += nn->biases[i][j];
+				row[j] = crelu(row[j]);
+			}
+		}
+
+		double* temp = current;
+		current = next;
+		next = temp;
+	}
+
+	free(current);
+	free(next);
+}
+
+/**
+ * @brief This function takes one gradient descent step on a batch, lowering the loss between the
+ *        networks outputs and the targets. The batch is passed forwards layer by layer like
+ *        batchFrontPropegation, keeping every layers sums, then the error is passed back.
+ * @param nn - this stores all of the networks data points, its weights and biases are updated
+ * @param inputs - batchSize rows of networkLayout[0] inputs
+ * @param targets - batchSize rows of networkLayout[networkSize-1] outputs the network should give
+ * @param batchSize - the number of rows in the batch
+ * @param loss - how the outputs are compared with the targets
+ * @param learningRate - the size of the step
+ * @return the mean loss of each row before the step
+ */
+double batchBackPropegation(neuralNetwork* nn, const double* inputs, const double* targets, int batchSize, networkLoss loss, double learningRate) {
+	int layers = nn->networkSize;
+	double** sums = calloc(layers, sizeof(double*));			//each layers weighted sums, before crelu
+	double** activations = calloc(layers, sizeof(double*));
+	double** deltas = calloc(layers, sizeof(double*));
+	for (int i = 0; i < layers; i++) {
+		sums[i] = malloc((size_t)batchSize * nn->networkLayout[i] * sizeof(double));
+		activations[i] = malloc((size_t)batchSize * nn->networkLayout[i] * sizeof(double));
+		deltas[i] = malloc((size_t)batchSize * nn->networkLayout[i] * sizeof(double));
+	}
+	memcpy(activations[0], inputs, (size_t)batchSize * nn->networkLayout[0] * sizeof(double));
+
+	for (int i = 0; i < layers - 1; i++) {
+		int in = nn->networkLayout[i];
+		int out = nn->networkLayout[i+1];
+		for (int b = 0; b < batchSize; b++) {
+			double* sum = &sums[i+1][b * out];
+			for (int j = 0; j < out; j++)
+				sum[j] = 0.0;
+			for (int k = 0; k < in; k++) {
+				double input = activations[i][b * in + k];
+				const double* w = nn->weights[i][k];
+				for (int j = 0; j < out; j++)
+					sum[j] += input * w[j];
+			}
+			for (int j = 0; j < out; j++) {
+				sum[j] += nn->biases[i][j];
+				activations[i+1][b * out + j] = crelu(sum[j]);
+			}
+		}
+	}
+
+	int outputs = nn->networkLayout[layers-1];
+	double error = 0;
+	for (int b = 0; b < batchSize; b++) {
+		const double* output = &activations[layers-1][b * outputs];
+		const double* target = &targets[b * outputs];
+		double* delta = &deltas[layers-1][b * outputs];
+
+		if (loss == LOSS_CROSS_ENTROPY) {
+			//the largest output is taken off first so exp can't overflow
+			double largest = output[0], total = 0;
+			for (int j = 1; j < outputs; j++)
+				largest = output[j] > largest ? output[j] : largest;
+			for (int j = 0; j < outputs; j++)
+				total += (delta[j] = exp(output[j] - largest));
+			for (int j = 0; j < outputs; j++) {
+				error -= target[j] * (output[j] - largest - log(total));
+				delta[j] = delta[j] / total - target[j];
+			}
+		} else {
+			for (int j = 0; j < outputs; j++) {
+				double difference = output[j] - target[j];
+				error += difference * difference;
+				delta[j] = 2 * difference;
+			}
+		}
+
+		for (int j = 0; j < outputs; j++) {
+			double sum = sums[layers-1][b * outputs + j];
+			delta[j] *= creluPrime(sum) / batchSize;
+		}
+	}
+
+	for (int i = layers - 2; i >= 0; i--) {
+		int in = nn->networkLayout[i];
+		int out = nn->networkLayout[i+1];
+
+		//the layer before's deltas use the weights as they were, so they are worked out first
+		if (i > 0) {
+			for (int b = 0; b < batchSize; b++) {
+				const double* delta = &deltas[i+1][b * out];
+				for (int k = 0; k < in; k++) {
+					const double* w = nn->weights[i][k];
+					double back = 0;
+					for (int j = 0; j < out; j++)
+						back += w[j] * delta[j];
+					double sum = sums[i][b * in + k];
+					deltas[i][b * in + k] = back * creluPrime(sum);
+				}
+			}
+		}
+
+		//weights[i][k] is contiguous over the output neurons, so the inner loop vectorises
+		for (int b = 0; b < batchSize; b++) {
+			const double* delta = &deltas[i+1][b * out];
+			for (int k = 0; k < in; k++) {
+				double step = learningRate * activations[i][b * in + k];
+				double* w = nn->weights[i][k];
+				for (int j = 0; j < out; j++)
+					w[j] -= step * delta[j];
+			}
+			for (int j = 0; j < out; j++)
+				nn->biases[i][j] -= learningRate * delta[j];
+		}
+	}
+
+	for (int i = 0; i < layers; i++) {
+		free(sums[i]);
+		free(activations[i]);
+		free(deltas[i]);
+	}
+	free(sums);
+	free(activations);
+	free(deltas);
+	return error / batchSize;
+}
+
 /**
  * @brief This function writes the network to a file for later use
  * @param nn - this stores the data points of the neural network
@@ -179,49 +522,166 @@ void saveBrain(neuralNetwork* nn, const char* filePath) {
 }
 
 /**
- * @brief This function reads the network from a file
- * @param nn - this stores the data points of the neural network
+ * @brief This function reads the network from a file. If the file has a different layout to the
+ * 		  network, the network is reallocated to the files layout. A file that can't be read, or
+ * 		  whose layout can't play the game, is reported and the program exits.
+ * @param nn - this stores the data points of the neural network, it must already be allocated
  * @param filePath - the file location you wish to read the file from
  * @return nothing
  */
 void loadBrain(neuralNetwork* nn, const char* filePath) {
 	FILE* f = fopen(filePath, "r");
-	printf("Hello world!");
+	if (f == NULL) {
+		printf("Error loading network, could not open %s\n", filePath);
+		exit(1);
+	}
 
 	char tempStr[4096];
 	const char delim[2] = ",";
 	char* token;
 
-	fscanf(f, "%s", tempStr);
+	if (fscanf(f, "%4095s", tempStr) != 1) {
+		printf("Error loading network, %s has no layout\n", filePath);
+		exit(1);
+	}
 
-	int i = 0;
-	for (token = strtok(tempStr, delim); token && *token; token = strtok(NULL, delim)) {
-		if (atoi(token) != nn->networkLayout[i]) {
-			printf("Error loading network, dimensions do not match\n");
-			exit(1);
-		}
-		i++;
+	int layout[NETWORK_MAX_LAYERS];
+	int networkSize = 0;
+	for (token = strtok(tempStr, delim); token && *token && networkSize < NETWORK_MAX_LAYERS; token = strtok(NULL, delim))
+		layout[networkSize++] = atoi(token);
+
+	if (networkSize < 2) {
+		printf("Error loading network, %s has no layout\n", filePath);
+		exit(1);
+	}
+	if (!playableLayout(layout, networkSize)) {
+		printf("Error loading network, %s must start with %d inputs and end with %d outputs\n", filePath, NETWORK_INPUTS, NETWORK_OUTPUTS);
+		exit(1);
+	}
+
+	if (networkSize != nn->networkSize || memcmp(layout, nn->networkLayout, networkSize * sizeof(int))) {
+		destroyBrainData(nn);
+		nn->networkSize = networkSize;
+		nn->networkLayout = calloc(networkSize, sizeof(int));
+		memcpy(nn->networkLayout, layout, networkSize * sizeof(int));
+		allocateNetworkBrain(nn);
 	}
 
 
 	char* e;
-	//writes the weight values to the file
+	int loaded = 1;
+	//reads the weight values from the file
 	for (int i = 0; i < nn->networkSize - 1; i++) {
 		for (int j = 0; j < nn->networkLayout[i]; j++) {
 			for (int k = 0; k < nn->networkLayout[i+1]; k++) {
-				fscanf(f, "%s", tempStr);
-				nn->weights[i][j][k] = strtod(tempStr, &e);
+				loaded = loaded && fscanf(f, "%4095s", tempStr) == 1;
+				nn->weights[i][j][k] = loaded ? strtod(tempStr, &e) : 0;
 			}
 		}
 	}
 
-	//writes the biases to the file
+	//reads the biases from the file
 	for (int i = 0; i < nn->networkSize - 1; i++) {
 		for (int j = 0; j < nn->networkLayout[i+1]; j++) {
-			fscanf(f, "%s", tempStr);
-			nn->biases[i][j] = strtod(tempStr, &e);
+			loaded = loaded && fscanf(f, "%4095s", tempStr) == 1;
+			nn->biases[i][j] = loaded ? strtod(tempStr, &e) : 0;
 		}
 	}
 
 	fclose(f);
+	if (!loaded) {
+		printf("Error loading network, %s ends before all of its weights\n", filePath);
+		exit(1);
+	}
+}
+
+/**
+ * @brief This function reads the next number of a mapped brain file, without copying it out first
+ * @param p - the read position, moved past the number
+ * @param end - the end of the mapping
+ * @param value - where the number is stored
+ * @return 1 if a number was read, 0 if the file ended or was malformed
+ */
+static int readMappedNumber(const char** p, const char* end, double* value) {
+	while (*p < end && (isspace((unsigned char)**p) || **p == ','))
+		(*p)++;
+	if (*p >= end)
+		return 0;
+
+	char* e;
+	*value = strtod(*p, &e);
+	if (e == *p)
+		return 0;
+
+	*p = e;
+	return 1;
+}
+
+/**
+ * @brief This function parses a brain from text that is already in memory
+ * @param nn - the network to load into, should not already be allocated
+ * @param p - the start of the brain text
+ * @param end - the end of the brain text, the last character must not be part of a number
+ * @return 1 if all went well, 0 if something went wrong (nn is left unallocated)
+ */
+static int parseMappedBrain(neuralNetwork* nn, const char* p, const char* end) {
+	//the layout is the first line, comma separated
+	const char* lineEnd = memchr(p, '\n', end - p);
+	int layout[256];
+	int networkSize = 0;
+	double value;
+	while (lineEnd && p < lineEnd && networkSize < 256 && readMappedNumber(&p, lineEnd, &value))
+		layout[networkSize++] = (int)value;
+
+	if (networkSize < 2 || !playableLayout(layout, networkSize))
+		return 0;
+
+	nn->networkSize = networkSize;
+	nn->networkLayout = calloc(networkSize, sizeof(int));
+	memcpy(nn->networkLayout, layout, networkSize * sizeof(int));
+	allocateNetworkBrain(nn);
+
+	int loaded = 1;
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i]; j++)
+			for (int k = 0; k < nn->networkLayout[i+1]; k++)
+				loaded = loaded && readMappedNumber(&p, end, &nn->weights[i][j][k]);
+
+	for (int i = 0; i < nn->networkSize - 1; i++)
+		for (int j = 0; j < nn->networkLayout[i+1]; j++)
+			loaded = loaded && readMappedNumber(&p, end, &nn->biases[i][j]);
+
+	if (!loaded)
+		destroyBrainData(nn);
+	return loaded;
+}
+
+/**
+ * @brief This function maps a brain file into memory and parses the weights straight from the
+ * 		  mapping. Unlike loadBrain the network is allocated to whatever layout the file has, and
+ * 		  a bad file is reported rather than exiting, so it is safe to call from worker threads.
+ * @param nn - the network to load into, should not already be allocated
+ * @param filePath - the file location you wish to read the file from
+ * @return 1 if all went well, 0 if something went wrong
+ */
+int mapBrain(neuralNetwork* nn, const char* filePath) {
+	int fd = open(filePath, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+		if (fd >= 0)
+			close(fd);
+		return 0;
+	}
+
+	const char* start = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (start == MAP_FAILED)
+		return 0;
+
+	//strtod only stops on a non number character, so the file has to end on one
+	const char* end = start + info.st_size;
+	int loaded = isspace((unsigned char)end[-1]) && parseMappedBrain(nn, start, end);
+
+	munmap((void*)start, info.st_size);
+	return loaded;
 }
\ No newline at end of file
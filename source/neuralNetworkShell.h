@@ -5,21 +5,44 @@
 #define crelu(x)(x>0.0?x:x*0.1)
 #define creluPrime(x)(x>0.0?1.0:0.1)
 
+#define NETWORK_MAX_LAYERS 64
+#define NETWORK_MAX_WIDTH 4096
+#define LAYER_BLOCK 4					//outputs the generic layer kernel works out together
+#define NETWORK_INPUTS 16				//the inputs getInputs fills
+#define NETWORK_OUTPUTS 3				//one per move, left, forward and right
+
+//passes one layer forwards, weights[k] is the row of weights from input k to every output
+typedef void (*layerKernel)(double**, const double*, const double*, double*, int, int);
+
 struct neuralNetwork {
     double*** weights;
     double** biases;
     double** outputs;
     int* networkLayout;
     int networkSize;
+	layerKernel* kernels;				//one per layer, picked for the layers shape when the network is allocated
 };
 typedef struct neuralNetwork neuralNetwork;
 
+enum networkLoss {
+	LOSS_SQUARED,						//the squared error between the outputs and the targets
+	LOSS_CROSS_ENTROPY					//the outputs are a softmaxs logits and the targets its probabilities
+};
+typedef enum networkLoss networkLoss;
+
 void setNetworkLayout(neuralNetwork*, int, ...);
+void setDefaultLayout(int, const int*);
+int readNetworkLayout(const char*, int*);
+int playableLayout(const int*, int);
 void initialiseNetworkBrain(neuralNetwork*);
+void allocateNetworkBrain(neuralNetwork*);
 void destroyBrainData(neuralNetwork*);
 void randomiseNetwork(neuralNetwork*);
 void deepCopy(neuralNetwork*, neuralNetwork*);
 void assignInputs(neuralNetwork*, double*);
 void frontPropegation(neuralNetwork*, int);
+void batchFrontPropegation(neuralNetwork*, const double*, double*, int);
+double batchBackPropegation(neuralNetwork*, const double*, const double*, int, networkLoss, double);
 void saveBrain(neuralNetwork*, const char*);
-void loadBrain(neuralNetwork*, const char*);
\ No newline at end of file
+void loadBrain(neuralNetwork*, const char*);
+int mapBrain(neuralNetwork*, const char*);
\ No newline at end of file
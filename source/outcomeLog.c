@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "outcomeLog.h"
+
+/**
+ * @brief This function creates an outcome log
+ * @param filePath - the file, replaced if it exists
+ * @param individuals - the individuals scored each generation
+ * @param games - the games each individual plays
+ * @return the log, or NULL if the file could not be created
+ */
+outcomeLog* openOutcomeLog(const char* filePath, int individuals, int games) {
+	FILE* f = fopen(filePath, "wb");
+	if (!f) {
+		printf("Could not create %s\n", filePath);
+		return NULL;
+	}
+	setvbuf(f, NULL, _IOFBF, OUTCOME_BUFFER);
+
+	outcomeFileHeader header = {OUTCOME_MAGIC, 0};
+	fwrite(&header, sizeof(header), 1, f);
+
+	outcomeLog* l = calloc(1, sizeof(outcomeLog));
+	l->f = f;
+	l->individuals = individuals;
+	l->games = games;
+	l->fitness = calloc(individuals, sizeof(double));
+	l->scores = calloc((size_t)individuals * games, sizeof(uint16_t));
+	l->ticks = calloc((size_t)individuals * games, sizeof(uint32_t));
+	l->deaths = calloc((size_t)individuals * games, sizeof(uint8_t));
+	l->offset = sizeof(header);
+	return l;
+}
+
+/**
+ * @brief This function stores how one game went, individuals may be recorded from several threads
+ * 		  as long as no two record the same individual
+ * @param l - the log
+ * @param individual - the individual that played
+ * @param game - which of its games it was
+ * @param s - the snake at the end of the game
+ * @return nothing
+ */
+void recordOutcome(outcomeLog* l, int individual, int game, snake* s) {
+	size_t i = (size_t)individual * l->games + game;
+	l->scores[i] = s->score;
+	l->ticks[i] = s->time;
+	l->deaths[i] = s->death;
+}
+
+/**
+ * @brief This function stores the fitness an individuals games were worth
+ * @param l - the log
+ * @param individual - the individual
+ * @param fitness - its fitness
+ * @return nothing
+ */
+void recordIndividualFitness(outcomeLog* l, int individual, double fitness) {
+	l->fitness[individual] = fitness;
+}
+
+/**
+ * @brief This function writes one column, padded to 8 bytes
+ * @param l - the log
+ * @param column - the column
+ * @param size - its size in bytes
+ * @return the file offset of the column
+ */
+static uint64_t writeColumn(outcomeLog* l, const void* column, size_t size) {
+	static const uint8_t padding[8] = {0};
+	uint64_t offset = l->offset;
+	size_t padded = (size + 7) & ~(size_t)7;
+	fwrite(column, 1, size, l->f);
+	fwrite(padding, 1, padded - size, l->f);
+	l->offset += padded;
+	return offset;
+}
+
+/**
+ * @brief This function appends the generation recorded so far and its footer. The stdio buffer is
+ * 		  flushed once at the end, so the file only ever ends on a whole generation.
+ * @param l - the log
+ * @param generation - the generation
+ * @return 1 if all went well, 0 if the file could not be written
+ */
+int writeOutcomeGeneration(outcomeLog* l, int generation) {
+	size_t games = (size_t)l->individuals * l->games;
+	outcomeFooter footer;
+	footer.magic = OUTCOME_FOOTER_MAGIC;
+	footer.generation = generation;
+	footer.individuals = l->individuals;
+	footer.games = l->games;
+	footer.fitness = writeColumn(l, l->fitness, l->individuals * sizeof(double));
+	footer.scores = writeColumn(l, l->scores, games * sizeof(uint16_t));
+	footer.ticks = writeColumn(l, l->ticks, games * sizeof(uint32_t));
+	footer.deaths = writeColumn(l, l->deaths, games * sizeof(uint8_t));
+	footer.previous = l->previous;
+
+	l->previous = l->offset;
+	writeColumn(l, &footer, sizeof(footer));
+	return fflush(l->f) == 0;
+}
+
+/**
+ * @brief This function closes an outcome log and frees it
+ * @param l - the log
+ * @return nothing
+ */
+void closeOutcomeLog(outcomeLog* l) {
+	fclose(l->f);
+	free(l->fitness);
+	free(l->scores);
+	free(l->ticks);
+	free(l->deaths);
+	free(l);
+}
+
+/**
+ * @brief This function checks a footer points inside the file, before anything it points to is read
+ * @param footer - the footer
+ * @param offset - where the footer is
+ * @return 1 if every column fits before the footer, 0 otherwise
+ */
+static int validFooter(const outcomeFooter* footer, uint64_t offset) {
+	uint64_t games = (uint64_t)footer->individuals * footer->games;
+	return footer->magic == OUTCOME_FOOTER_MAGIC && footer->previous < offset &&
+		footer->fitness + footer->individuals * sizeof(double) <= offset &&
+		footer->scores + games * sizeof(uint16_t) <= offset &&
+		footer->ticks + games * sizeof(uint32_t) <= offset &&
+		footer->deaths + games <= offset;
+}
+
+/**
+ * @brief This function prints every generation of an outcome log, from the last back to the
+ * 		  first, only the columns that are read are paged in
+ * @param filePath - the outcome log
+ * @return 1 if all went well, 0 if the file could not be read
+ */
+int summariseOutcomes(const char* filePath) {
+	int fd = open(filePath, O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0 || info.st_size < (off_t)(sizeof(outcomeFileHeader) + sizeof(outcomeFooter))) {
+		if (fd >= 0)
+			close(fd);
+		printf("%s is not an outcome log\n", filePath);
+		return 0;
+	}
+
+	const uint8_t* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED || ((const outcomeFileHeader*)map)->magic != OUTCOME_MAGIC) {
+		if (map != MAP_FAILED)
+			munmap((void*)map, info.st_size);
+		printf("%s is not an outcome log\n", filePath);
+		return 0;
+	}
+
+	printf("Generation\tindividuals\tmean score\tbest score\tmean ticks\twall\tbody\tstarved\n");
+	uint64_t offset = info.st_size - sizeof(outcomeFooter);
+	while (offset >= sizeof(outcomeFileHeader)) {
+		const outcomeFooter* footer = (const outcomeFooter*)(map + offset);
+		if (!validFooter(footer, offset)) {
+			printf("Corrupt footer at byte %llu\n", (unsigned long long)offset);
+			break;
+		}
+
+		const uint16_t* scores = (const uint16_t*)(map + footer->scores);
+		const uint32_t* ticks = (const uint32_t*)(map + footer->ticks);
+		const uint8_t* deaths = map + footer->deaths;
+		size_t games = (size_t)footer->individuals * footer->games;
+		double score = 0, time = 0;
+		long long causes[3] = {0};
+		int best = 0;
+		for (size_t i = 0; i < games; i++) {
+			score += scores[i];
+			time += ticks[i];
+			best = scores[i] > best ? scores[i] : best;
+			causes[deaths[i] < 3 ? deaths[i] : DEATH_NONE]++;
+		}
+
+		printf("%d\t\t%u\t\t%.2lf\t\t%d\t\t%.1lf\t\t%.1lf%%\t%.1lf%%\t%.1lf%%\n", footer->generation, footer->individuals,
+			score / games, best, time / games, 100.0 * causes[DEATH_WALL] / games,
+			100.0 * causes[DEATH_BODY] / games, 100.0 * causes[DEATH_NONE] / games);
+
+		if (footer->previous == 0)
+			break;
+		offset = footer->previous;
+	}
+
+	munmap((void*)map, info.st_size);
+	return 1;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "snakeGame.h"
+
+#define OUTCOME_MAGIC 0x4f4b4e53		//"SNKO"
+#define OUTCOME_FOOTER_MAGIC 0x544f4f46	//"FOOT"
+#define OUTCOME_BUFFER (1 << 20)		//bytes buffered before the file is written
+
+/*
+	An outcome log is an outcomeFileHeader followed by one block per generation, appended as
+	each generation finishes. A block is its columns, each padded to 8 bytes:
+		float64 fitness, one per individual
+		uint16 score, one per game, an individuals games next to each other
+		uint32 ticks, how long each game lasted
+		uint8 death, the deathCause of each game, DEATH_NONE if the snake starved
+	and then an outcomeFooter with the offset of every column and of the previous footer. The
+	last footer always ends the file, so a reader can map it and walk back through the generations.
+*/
+struct outcomeFileHeader {
+	uint32_t magic;
+	uint32_t reserved;
+};
+typedef struct outcomeFileHeader outcomeFileHeader;
+
+struct outcomeFooter {
+	uint32_t magic;
+	int32_t generation;
+	uint32_t individuals;
+	uint32_t games;						//games each individual played
+	uint64_t fitness;					//file offsets of the columns
+	uint64_t scores;
+	uint64_t ticks;
+	uint64_t deaths;
+	uint64_t previous;					//file offset of the previous footer, 0 if this is the first
+};
+typedef struct outcomeFooter outcomeFooter;
+
+struct outcomeLog {
+	FILE* f;
+	int individuals;
+	int games;
+	double* fitness;					//the generation being played
+	uint16_t* scores;
+	uint32_t* ticks;
+	uint8_t* deaths;
+	uint64_t offset;					//bytes written so far
+	uint64_t previous;					//the last footer written, 0 if there isn't one
+};
+typedef struct outcomeLog outcomeLog;
+
+outcomeLog* openOutcomeLog(const char*, int, int);
+void recordOutcome(outcomeLog*, int, int, snake*);
+void recordIndividualFitness(outcomeLog*, int, double);
+int writeOutcomeGeneration(outcomeLog*, int);
+void closeOutcomeLog(outcomeLog*);
+int summariseOutcomes(const char*);
@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "planner.h"
+#include "snakeGame.h"
+#include "neuralNetworkShell.h"
+#include "geneticNeuralNetwork.h"
+#include "main.h"
+
+/**
+ * @brief This function compares two rankings, for qsort, the highest key first
+ * @param a - a planRanking
+ * @param b - another planRanking
+ * @return -1, 0 or 1 as a should come before, with or after b
+ */
+static int compareRankings(const void* a, const void* b) {
+	double x = ((const planRanking*)a)->key;
+	double y = ((const planRanking*)b)->key;
+	return (x < y) - (x > y);
+}
+
+/**
+ * @brief This function checks whether the time for this move has run out
+ * @param deadline - when it runs out
+ * @return 1 if it has, 0 otherwise
+ */
+static int pastDeadline(const struct timespec* deadline) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/**
+ * @brief This function checks whether a states head has reached the food
+ * @param g - the state
+ * @return 1 if it has, 0 otherwise
+ */
+static int reachedFood(const gameState* g) {
+	return g->foodX >= 0 && g->headX == g->foodX && g->headY == g->foodY;
+}
+
+/**
+ * @brief This function searches one root move until the deadline or PLAN_MAX_DEPTH, see planner.h
+ * @param arg - the planSearch, its root is the state after the move
+ * @return NULL
+ */
+static void* searchRootMove(void* arg) {
+	planSearch* p = arg;
+	lookaheadPlanner* planner = p->planner;
+	int inputs = planner->nn->networkLayout[0];
+	int outputs = planner->nn->networkLayout[planner->nn->networkSize - 1];
+
+	p->depth = 0;
+	p->diedAt = 1;
+	p->foodAt = 0;
+	if (!p->root.alive)
+		return NULL;
+
+	p->beam[0].state = p->root;
+	p->beam[0].prior = 0;
+	p->beam[0].ateAt = reachedFood(&p->root);
+	p->depth = 1;
+	p->diedAt = 0;
+	p->foodAt = p->beam[0].ateAt;
+
+	int count = 1;
+	for (int depth = 2; depth <= PLAN_MAX_DEPTH && !pastDeadline(&planner->deadline); depth++) {
+		for (int i = 0; i < count; i++)
+			senseGameState(&p->beam[i].state, &p->inputs[i * inputs]);
+		batchFrontPropegation(planner->nn, p->inputs, p->outputs, count);
+
+		int children = 0;
+		for (int i = 0; i < count; i++) {
+			//the outputs are a softmaxs logits, the largest is taken off so exp can't overflow
+			const double* output = &p->outputs[i * outputs];
+			double largest = fmax(output[0], fmax(output[1], output[2]));
+			double total = exp(output[0] - largest) + exp(output[1] - largest) + exp(output[2] - largest);
+
+			for (int move = 0; move < 3; move++) {
+				planNode* child = &p->children[children];
+				child->state = p->beam[i].state;
+				stepGameState(&child->state, move - 1);
+				if (!child->state.alive)
+					continue;
+
+				child->prior = p->beam[i].prior + output[move] - largest - log(total);
+				child->ateAt = p->beam[i].ateAt ? p->beam[i].ateAt : reachedFood(&child->state) ? depth : 0;
+				p->ranking[children].key = child->prior + (child->ateAt ? PLAN_FOOD_VALUE : 0);
+				p->ranking[children].index = children;
+				children++;
+			}
+		}
+		if (children == 0) {
+			p->diedAt = depth;
+			break;
+		}
+
+		qsort(p->ranking, children, sizeof(planRanking), compareRankings);
+		count = children < PLAN_BEAM ? children : PLAN_BEAM;
+		for (int i = 0; i < count; i++) {
+			p->beam[i] = p->children[p->ranking[i].index];
+			if (!p->foodAt)
+				p->foodAt = p->beam[i].ateAt;
+		}
+		p->depth = depth;
+	}
+	return NULL;
+}
+
+/**
+ * @brief This function sets up a planner, the search buffers are allocated once here
+ * @param p - the planner
+ * @param nn - the network whose outputs guide the search, it must not change while the planner is used
+ * @param budget - milliseconds each move may take
+ * @return nothing
+ */
+void initialisePlanner(lookaheadPlanner* p, neuralNetwork* nn, int budget) {
+	p->nn = nn;
+	p->budget = budget;
+	p->depths = 0;
+	p->moves = 0;
+	for (int i = 0; i < 3; i++) {
+		planSearch* search = &p->searches[i];
+		search->planner = p;
+		search->move = i - 1;
+		search->beam = malloc(PLAN_BEAM * sizeof(planNode));
+		search->children = malloc(3 * PLAN_BEAM * sizeof(planNode));
+		search->ranking = malloc(3 * PLAN_BEAM * sizeof(planRanking));
+		search->inputs = malloc((size_t)PLAN_BEAM * nn->networkLayout[0] * sizeof(double));
+		search->outputs = malloc((size_t)PLAN_BEAM * nn->networkLayout[nn->networkSize - 1] * sizeof(double));
+	}
+}
+
+/**
+ * @brief This function frees a planners search buffers
+ * @param p - the planner
+ * @return nothing
+ */
+void destroyPlanner(lookaheadPlanner* p) {
+	for (int i = 0; i < 3; i++) {
+		free(p->searches[i].beam);
+		free(p->searches[i].children);
+		free(p->searches[i].ranking);
+		free(p->searches[i].inputs);
+		free(p->searches[i].outputs);
+	}
+}
+
+/**
+ * @brief This function picks the next move of a game by searching each root move on its own
+ * 		  thread for the planners budget
+ * @param p - the planner
+ * @param s - the snake
+ * @param b - the board
+ * @return the move, -1 left, 0 forward, 1 right, as s->move takes it
+ */
+int planMove(lookaheadPlanner* p, snake* s, board* b) {
+	gameState now;
+	captureGameState(s, b, &now);
+	clock_gettime(CLOCK_MONOTONIC, &p->deadline);
+	p->deadline.tv_sec += p->budget / 1000;
+	p->deadline.tv_nsec += p->budget % 1000 * 1000000L;
+	if (p->deadline.tv_nsec >= 1000000000L) {
+		p->deadline.tv_sec++;
+		p->deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_t threads[3];
+	for (int i = 0; i < 3; i++) {
+		p->searches[i].root = now;
+		stepGameState(&p->searches[i].root, p->searches[i].move);
+		pthread_create(&threads[i], NULL, searchRootMove, &p->searches[i]);
+	}
+	for (int i = 0; i < 3; i++)
+		pthread_join(threads[i], NULL);
+
+	//the searches share the cores unevenly, so they are compared at the depth all the ones still alive reached
+	int common = PLAN_MAX_DEPTH;
+	for (int i = 0; i < 3; i++) {
+		planSearch* search = &p->searches[i];
+		if (!search->diedAt && search->depth < common)
+			common = search->depth;
+		p->depths += search->depth;
+	}
+	for (int i = 0; i < 3; i++) {
+		planSearch* search = &p->searches[i];
+		int survived = search->diedAt ? search->diedAt - 1 : search->depth;
+		search->value = survived < common ? survived : common;
+		if (search->foodAt && search->foodAt <= common)
+			search->value += PLAN_FOOD_VALUE - search->foodAt;
+	}
+
+	//the searches only read the network, so its own outputs can be used again now they are done
+	getInputs(p->nn, s, b);
+	frontPropegation(p->nn, 0);
+	int best = getOutput(p->nn);
+	for (int i = 0; i < 3; i++)
+		if (p->searches[i].value > p->searches[best].value)
+			best = i;
+	p->moves++;
+	return best - 1;
+}
+
+/**
+ * @brief This function plays the same games with the network alone and with the planner, and
+ * 		  prints how they did. The games have the starvation budgets training uses.
+ * @param nn - the network
+ * @param games - the games played each way
+ * @param seed - the seed the games are picked with
+ * @param budget - milliseconds the planner may take each move
+ * @return 1
+ */
+int comparePlanner(neuralNetwork* nn, int games, unsigned int seed, int budget) {
+	lookaheadPlanner p;
+	initialisePlanner(&p, nn, budget);
+	int startBudget, foodBudget;
+	getStarvationBudget(&startBudget, &foodBudget);
+
+	snake s;
+	board b;
+	double scores[2] = {0};
+	int best[2] = {0};
+	int deaths[2][3] = {{0}};
+	for (int i = 0; i < games; i++) {
+		unsigned int gameSeed = rand_r(&seed);
+		b.seed = gameSeed;
+		playCompTrain(nn, &s, &b, NULL, NULL);
+		int networkScore = s.score;
+		scores[0] += s.score;
+		best[0] = s.score > best[0] ? s.score : best[0];
+		deaths[0][s.death]++;
+		free(s.x);
+		free(s.y);
+
+		initiliseSeededSnakeAndBoard(&s, &b, gameSeed);
+		int ticksSinceAteFood = startBudget;
+		while (s.alive && ticksSinceAteFood > 0) {
+			if (s.x[0] == b.foodX && s.y[0] == b.foodY)
+				ticksSinceAteFood += foodBudget;
+			s.move = planMove(&p, &s, &b);
+			updateSnake(&s, &b);
+			ticksSinceAteFood--;
+		}
+		scores[1] += s.score;
+		best[1] = s.score > best[1] ? s.score : best[1];
+		deaths[1][s.death]++;
+		printf("Game %d: the network scored %d, with the planner %d\n", i+1, networkScore, s.score);
+		free(s.x);
+		free(s.y);
+	}
+
+	const char* names[2] = {"Network", "Planner"};
+	for (int i = 0; i < 2; i++)
+		printf("%s: mean score %.2lf, best %d, %d hit a wall, %d hit the body, %d starved\n", names[i], scores[i] / games,
+			best[i], deaths[i][DEATH_WALL], deaths[i][DEATH_BODY], deaths[i][DEATH_NONE]);
+	printf("The planner looked %.1lf ticks ahead on average, with %dms a move\n", (double)p.depths / (3 * p.moves), budget);
+
+	destroyPlanner(&p);
+	return 1;
+}
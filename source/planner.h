@@ -0,0 +1,63 @@
+#pragma once
+#include <time.h>
+
+#include "snakeGame.h"
+#include "neuralNetworkShell.h"
+
+#define PLAN_BUDGET 20					//milliseconds each move may take, when plan is given no value
+#define PLAN_BEAM 64					//states each root moves search keeps at every depth
+#define PLAN_MAX_DEPTH 200				//ticks looked ahead, searching stops here even with time left
+#define PLAN_FOOD_VALUE 100				//what reaching the food is worth, less the ticks it takes, next to 1 per tick survived
+
+struct planNode {
+	gameState state;
+	double prior;						//the log probability the network gives the moves that led here
+	int ateAt;							//the depth the food was eaten at, 0 if it hasn't been
+};
+typedef struct planNode planNode;
+
+struct planRanking {
+	double key;
+	int index;
+};
+typedef struct planRanking planRanking;
+
+/*
+	Each root move is searched on its own thread. A beam of the PLAN_BEAM most promising states
+	is grown one tick at a time: every state tries all 3 moves, dead children are dropped and
+	the rest are ranked by the networks log probability of the moves, with a bonus once the food
+	is eaten. The searches are compared at the shallowest depth any of them was stopped at
+	without its beam dying out. Up to there a root move is worth the depth its beam survives to,
+	plus PLAN_FOOD_VALUE - the depth the food was first reached at. The root move worth the most
+	is played, the network breaking ties.
+*/
+struct planSearch {
+	struct lookaheadPlanner* planner;
+	int move;							//-1, 0 or 1
+	gameState root;
+	planNode* beam;						//PLAN_BEAM states
+	planNode* children;					//3 * PLAN_BEAM states
+	planRanking* ranking;
+	double* inputs;
+	double* outputs;
+	int depth;							//the depth searched to, 0 if the move dies straight away
+	int diedAt;							//the depth every state of the beam was dead at, 0 if it never was
+	int foodAt;							//the depth the food was first reached at, 0 if it wasn't
+	double value;						//worked out by planMove once every search is done
+};
+typedef struct planSearch planSearch;
+
+struct lookaheadPlanner {
+	neuralNetwork* nn;					//shared by the searches, only read
+	int budget;							//milliseconds per move
+	struct timespec deadline;
+	planSearch searches[3];
+	long long depths;					//summed over every root move of every move planned, for the report
+	long long moves;
+};
+typedef struct lookaheadPlanner lookaheadPlanner;
+
+void initialisePlanner(lookaheadPlanner*, neuralNetwork*, int);
+void destroyPlanner(lookaheadPlanner*);
+int planMove(lookaheadPlanner*, snake*, board*);
+int comparePlanner(neuralNetwork*, int, unsigned int, int);
@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "neuralNetworkShell.h"
+#include "quantisedNetwork.h"
+#include "geneticNeuralNetwork.h"
+#include "snakeGame.h"
+
+/**
+ * @brief This function allocates the (zeroed) buffers of a quantised network with the given layout.
+ * 		  If something goes wrong, whatever was allocated is freed again.
+ * @param q - the quantised network to allocate
+ * @param networkSize - the number of layers, including the input and output layers
+ * @param networkLayout - the size of each layer
+ * @param bits - the width of the stored weights, 8 or 16
+ * @return 1 if all went well, 0 if something went wrong
+ */
+static int allocateQuantisedNetwork(quantisedNetwork* q, int networkSize, const int* networkLayout, int bits) {
+	if (bits != 8 && bits != 16) {
+		printf("Quantised networks must be 8 or 16 bit\n");
+		return 0;
+	}
+
+	q->bits = bits;
+	q->networkSize = networkSize;
+	q->networkLayout = calloc(networkSize, sizeof(int));
+	q->paddedLayout = calloc(networkSize, sizeof(int));
+	q->weights = bits == 16 ? calloc(networkSize - 1, sizeof(int16_t*)) : NULL;
+	q->weights8 = bits == 8 ? calloc(networkSize - 1, sizeof(int8_t*)) : NULL;
+	q->biases = calloc(networkSize - 1, sizeof(double*));
+	q->weightScales = calloc(networkSize - 1, sizeof(double));
+	q->activationLimits = calloc(networkSize - 1, sizeof(int));
+
+	for (int i = 0; i < networkSize; i++) {
+		q->networkLayout[i] = networkLayout[i];
+		q->paddedLayout[i] = (networkLayout[i] + QUANTISED_LANES - 1) / QUANTISED_LANES * QUANTISED_LANES;
+	}
+
+	int weightLimit = (1 << (bits - 1)) - 1;
+	for (int i = 0; i < networkSize - 1; i++) {
+		size_t rowsSize = (size_t)q->paddedLayout[i] * networkLayout[i+1] * (bits / 8);
+		void** rows = bits == 16 ? (void**)&q->weights[i] : (void**)&q->weights8[i];
+		if (posix_memalign(rows, 16, rowsSize ? rowsSize : 16) != 0) {
+			*rows = NULL;
+			destroyQuantisedNetwork(q);
+			return 0;
+		}
+		memset(*rows, 0, rowsSize);
+		q->biases[i] = calloc(networkLayout[i+1], sizeof(double));
+
+		//the int32 accumulator must hold weightLimit * activationLimit * inputs without overflowing
+		long long limit = INT_MAX / ((long long)weightLimit * q->paddedLayout[i]);
+		q->activationLimits[i] = limit < weightLimit ? (int)limit : weightLimit;
+	}
+	return 1;
+}
+
+/**
+ * @brief This function stores one quantised weight, in whichever width the network uses
+ * @param q - the quantised network
+ * @param layer - the layer the weight feeds out of
+ * @param index - the position of the weight in the layers padded rows
+ * @param weight - the quantised weight, already in range for q->bits
+ * @return nothing
+ */
+static void setQuantisedWeight(quantisedNetwork* q, int layer, int index, int weight) {
+	if (q->bits == 8)
+		q->weights8[layer][index] = (int8_t)weight;
+	else
+		q->weights[layer][index] = (int16_t)weight;
+}
+
+/**
+ * @brief This function reads one quantised weight, in whichever width the network uses
+ * @param q - the quantised network
+ * @param layer - the layer the weight feeds out of
+ * @param index - the position of the weight in the layers padded rows
+ * @return the quantised weight
+ */
+static int getQuantisedWeight(quantisedNetwork* q, int layer, int index) {
+	return q->bits == 8 ? q->weights8[layer][index] : q->weights[layer][index];
+}
+
+/**
+ * @brief This function quantises a trained network into fixed point, with one weight scale per layer
+ * @param nn - the trained network to quantise, it is not modified
+ * @param q - the quantised network, should not already be allocated
+ * @param bits - the width of the stored weights, 8 or 16
+ * @return 1 if all went well, 0 if something went wrong
+ */
+int quantiseNetwork(neuralNetwork* nn, quantisedNetwork* q, int bits) {
+	if (!allocateQuantisedNetwork(q, nn->networkSize, nn->networkLayout, bits))
+		return 0;
+
+	int weightLimit = (1 << (bits - 1)) - 1;
+	for (int i = 0; i < nn->networkSize - 1; i++) {
+		double maxWeight = 0;
+		for (int j = 0; j < nn->networkLayout[i]; j++)
+			for (int k = 0; k < nn->networkLayout[i+1]; k++)
+				if (fabs(nn->weights[i][j][k]) > maxWeight)
+					maxWeight = fabs(nn->weights[i][j][k]);
+
+		q->weightScales[i] = maxWeight > 0 ? maxWeight / weightLimit : 1;
+
+		//stored transposed, so each output neuron reads one contiguous row
+		for (int j = 0; j < nn->networkLayout[i+1]; j++) {
+			for (int k = 0; k < nn->networkLayout[i]; k++)
+				setQuantisedWeight(q, i, j * q->paddedLayout[i] + k, (int)lrint(nn->weights[i][k][j] / q->weightScales[i]));
+
+			q->biases[i][j] = nn->biases[i][j];
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief This function frees the memory of a quantised network
+ * @param q - the quantised network
+ * @return nothing
+ */
+void destroyQuantisedNetwork(quantisedNetwork* q) {
+	for (int i = 0; i < q->networkSize - 1; i++) {
+		if (q->weights)
+			free(q->weights[i]);
+		if (q->weights8)
+			free(q->weights8[i]);
+		free(q->biases[i]);
+	}
+	free(q->weights);
+	free(q->weights8);
+	free(q->biases);
+	free(q->weightScales);
+	free(q->activationLimits);
+	free(q->paddedLayout);
+	free(q->networkLayout);
+}
+
+/**
+ * @brief This function takes the dot product of a 16 bit weight row and the quantised activations
+ * @param weights - a 16 byte aligned row of weights, padded to a multiple of QUANTISED_LANES
+ * @param activations - the quantised activations, padded the same way
+ * @param length - the padded length of both rows
+ * @return the int32 sum of the products
+ */
+static int32_t quantisedDotProduct(const int16_t* weights, const int16_t* activations, int length) {
+#ifdef __SSE2__
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < length; i += 8) {
+		__m128i w = _mm_load_si128((const __m128i*)(weights + i));
+		__m128i a = _mm_loadu_si128((const __m128i*)(activations + i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(w, a));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+#else
+	int32_t sum = 0;
+	for (int i = 0; i < length; i++)
+		sum += (int32_t)weights[i] * activations[i];
+	return sum;
+#endif
+}
+
+/**
+ * @brief This function takes the dot product of an 8 bit weight row and the quantised activations.
+ * 		  SSE2 has no 8 bit multiply-add, so each register of 16 is sign extended into two halves
+ * 		  and multiplied as 16 bit, the weights still only take one byte each in memory.
+ * @param weights - a 16 byte aligned row of weights, padded to a multiple of QUANTISED_LANES
+ * @param activations - the quantised activations, padded the same way
+ * @param length - the padded length of both rows
+ * @return the int32 sum of the products
+ */
+static int32_t quantisedDotProduct8(const int8_t* weights, const int8_t* activations, int length) {
+#ifdef __SSE2__
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < length; i += QUANTISED_LANES) {
+		__m128i w = _mm_load_si128((const __m128i*)(weights + i));
+		__m128i a = _mm_loadu_si128((const __m128i*)(activations + i));
+		//putting each byte in the top half of a 16 bit lane then shifting it down sign extends it
+		__m128i wLow = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+		__m128i wHigh = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+		__m128i aLow = _mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8);
+		__m128i aHigh = _mm_srai_epi16(_mm_unpackhi_epi8(a, a), 8);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(wLow, aLow));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(wHigh, aHigh));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+#else
+	int32_t sum = 0;
+	for (int i = 0; i < length; i++)
+		sum += (int32_t)weights[i] * activations[i];
+	return sum;
+#endif
+}
+
+/**
+ * @brief This function is a drop in replacement for frontPropegation, it passes the input
+ * 		  (the 0th element of the output arr) through the quantised network. Each layers
+ * 		  activations are quantised on the fly to the same width as the weights, so all of the
+ * 		  multiply-adds are done in integers.
+ * @param q - the quantised network
+ * @param nn - a network with the same layout, its inputs are read and its outputs are written
+ * @return nothing
+ */
+void quantisedFrontPropegation(quantisedNetwork* q, neuralNetwork* nn) {
+	for (int i = 0; i < q->networkSize - 1; i++) {
+		int16_t activations[q->paddedLayout[i]];
+		int8_t activations8[q->paddedLayout[i]];
+		double maxActivation = 0;
+
+		for (int k = 0; k < q->networkLayout[i]; k++)
+			if (fabs(nn->outputs[i][k]) > maxActivation)
+				maxActivation = fabs(nn->outputs[i][k]);
+
+		double activationScale = maxActivation > 0 ? q->activationLimits[i] / maxActivation : 1;
+		for (int k = 0; k < q->paddedLayout[i]; k++) {
+			activations[k] = k < q->networkLayout[i] ? (int16_t)lrint(nn->outputs[i][k] * activationScale) : 0;
+			activations8[k] = (int8_t)activations[k];
+		}
+
+		double outputScale = q->weightScales[i] / activationScale;
+		for (int j = 0; j < q->networkLayout[i+1]; j++) {
+			int32_t sum = q->bits == 8
+				? quantisedDotProduct8(&q->weights8[i][j * q->paddedLayout[i]], activations8, q->paddedLayout[i])
+				: quantisedDotProduct(&q->weights[i][j * q->paddedLayout[i]], activations, q->paddedLayout[i]);
+			double output = sum * outputScale + q->biases[i][j];
+			nn->outputs[i+1][j] = crelu(output);
+		}
+	}
+}
+
+/**
+ * @brief This function writes the quantised network to a file for later use
+ * @param q - the quantised network
+ * @param filePath - the file location you wish to save the file to
+ * @return nothing
+ */
+void saveQuantisedBrain(quantisedNetwork* q, const char* filePath) {
+	FILE* f = fopen(filePath, "w");
+
+	//writes the network structure and the weight width to a file
+	for (int i = 0; i < q->networkSize - 1; i++)
+		fprintf(f, "%d,", q->networkLayout[i]);
+	fprintf(f, "%d\n", q->networkLayout[q->networkSize-1]);
+	fprintf(f, "%d\n", q->bits);
+
+	//writes the scale, weights then biases of each layer
+	for (int i = 0; i < q->networkSize - 1; i++) {
+		fprintf(f, "%.17g\n", q->weightScales[i]);
+		for (int j = 0; j < q->networkLayout[i+1]; j++)
+			for (int k = 0; k < q->networkLayout[i]; k++)
+				fprintf(f, "%d\n", getQuantisedWeight(q, i, j * q->paddedLayout[i] + k));
+
+		for (int j = 0; j < q->networkLayout[i+1]; j++)
+			fprintf(f, "%.17g\n", q->biases[i][j]);
+	}
+
+	fclose(f);
+}
+
+/**
+ * @brief This function reads a quantised network from a file, as written by saveQuantisedBrain
+ * @param q - the quantised network, should not already be allocated, it is left unallocated on failure
+ * @param filePath - the file location you wish to read the file from
+ * @return 1 if all went well, 0 if something went wrong
+ */
+int loadQuantisedBrain(quantisedNetwork* q, const char* filePath) {
+	FILE* f = fopen(filePath, "r");
+	if (f == NULL) {
+		printf("Could not open %s\n", filePath);
+		return 0;
+	}
+
+	char tempStr[4096];
+	int layout[NETWORK_MAX_LAYERS];
+	int networkSize = 0;
+	int bits;
+
+	if (fscanf(f, "%4095s %d", tempStr, &bits) != 2) {
+		printf("Error loading quantised network, %s has no layout\n", filePath);
+		fclose(f);
+		return 0;
+	}
+
+	for (char* token = strtok(tempStr, ","); token && networkSize < NETWORK_MAX_LAYERS; token = strtok(NULL, ","))
+		layout[networkSize++] = atoi(token);
+
+	if (!playableLayout(layout, networkSize)) {
+		printf("Error loading quantised network, %s must start with %d inputs and end with %d outputs\n", filePath, NETWORK_INPUTS, NETWORK_OUTPUTS);
+		fclose(f);
+		return 0;
+	}
+	if (!allocateQuantisedNetwork(q, networkSize, layout, bits)) {
+		fclose(f);
+		return 0;
+	}
+
+	int weightLimit = (1 << (bits - 1)) - 1;
+	int loaded = 1;
+	for (int i = 0; loaded && i < q->networkSize - 1; i++) {
+		loaded = fscanf(f, "%lf", &q->weightScales[i]) == 1;
+		for (int j = 0; loaded && j < q->networkLayout[i+1]; j++) {
+			for (int k = 0; loaded && k < q->networkLayout[i]; k++) {
+				int weight;
+				loaded = fscanf(f, "%d", &weight) == 1 && weight >= -weightLimit && weight <= weightLimit;
+				if (loaded)
+					setQuantisedWeight(q, i, j * q->paddedLayout[i] + k, weight);
+			}
+		}
+
+		for (int j = 0; loaded && j < q->networkLayout[i+1]; j++)
+			loaded = fscanf(f, "%lf", &q->biases[i][j]) == 1;
+	}
+
+	fclose(f);
+	if (!loaded) {
+		printf("Error loading quantised network, %s is truncated or has a weight out of range\n", filePath);
+		destroyQuantisedNetwork(q);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief This function plays games with the original network and checks, on every tick, whether
+ * 		  the quantised network would have chosen the same move. Prints a report.
+ * @param nn - the original network, it drives the games
+ * @param q - the quantised version of nn
+ * @param games - the number of games to play
+ * @return the fraction of ticks where both networks chose the same move
+ */
+double quantisedAgreement(neuralNetwork* nn, quantisedNetwork* q, int games) {
+	snake* s = malloc(sizeof(snake));
+	board* b = malloc(sizeof(board));
+	long long ticks = 0;
+	long long agreed = 0;
+	int perfectGames = 0;
+	int startBudget, foodBudget;
+	getStarvationBudget(&startBudget, &foodBudget);
+
+	for (int i = 0; i < games; i++) {
+		initiliseSnakeAndBoard(s, b);
+		int ticksSinceAteFood = startBudget;
+		int disagreed = 0;
+
+		while (s->alive && ticksSinceAteFood > 0) {
+			if (s->x[0] == b->foodX && s->y[0] == b->foodY)
+				ticksSinceAteFood += foodBudget;
+
+			getInputs(nn, s, b);
+			quantisedFrontPropegation(q, nn);
+			int quantisedMove = getOutput(nn);
+
+			frontPropegation(nn, 0);
+			int move = getOutput(nn);
+
+			ticks++;
+			if (move == quantisedMove)
+				agreed++;
+			else
+				disagreed++;
+
+			s->move = move - 1;
+			updateSnake(s, b);
+			ticksSinceAteFood--;
+		}
+
+		if (!disagreed)
+			perfectGames++;
+
+		free(s->x);
+		free(s->y);
+	}
+
+	double agreement = ticks ? (double)agreed / ticks : 1;
+	printf("%d bit agreement over %d games: %lld/%lld moves (%.2lf%%), %d games without a disagreement\n",
+		q->bits, games, agreed, ticks, agreement * 100, perfectGames);
+
+	free(s);
+	free(b);
+	return agreement;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+
+#include "neuralNetworkShell.h"
+
+#define QUANTISED_LANES 16		//int8 lanes per SSE2 register, rows are padded to a multiple of this
+
+struct quantisedNetwork {
+	int16_t** weights;			//16 bit weights, weights[i] holds one padded row of inputs per output neuron of layer i+1
+	int8_t** weights8;			//8 bit weights, laid out the same way, only one of weights and weights8 is allocated
+	double** biases;			//biases are kept in full precision, they are added after dequantising
+	double* weightScales;		//real weight = quantised weight * weightScales[i]
+	int* activationLimits;		//largest quantised activation magnitude for each layer, keeps the int32 sum in range
+	int* networkLayout;
+	int* paddedLayout;
+	int networkSize;
+	int bits;					//8 or 16, the width of both the stored weights and the activations
+};
+typedef struct quantisedNetwork quantisedNetwork;
+
+int quantiseNetwork(neuralNetwork*, quantisedNetwork*, int);
+void destroyQuantisedNetwork(quantisedNetwork*);
+void quantisedFrontPropegation(quantisedNetwork*, neuralNetwork*);
+void saveQuantisedBrain(quantisedNetwork*, const char*);
+int loadQuantisedBrain(quantisedNetwork*, const char*);
+double quantisedAgreement(neuralNetwork*, quantisedNetwork*, int);
@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "replay.h"
+#include "snakeGame.h"
+
+/**
+ * @brief This function sets up an empty replay
+ * @param r - the replay
+ * @return nothing
+ */
+void initialiseReplay(replay* r) {
+	memset(r, 0, sizeof(replay));
+	r->header.magic = REPLAY_MAGIC;
+	r->header.generation = -1;
+}
+
+/**
+ * @brief This function frees the moves of a replay
+ * @param r - the replay
+ * @return nothing
+ */
+void destroyReplay(replay* r) {
+	free(r->moves);
+	r->moves = NULL;
+	r->capacity = 0;
+}
+
+/**
+ * @brief This function clears a replay so a new game can be recorded into it, the move buffer is kept
+ * @param r - the replay
+ * @param seed - the seed the game is started with
+ * @param generation - the training generation, or -1
+ * @return nothing
+ */
+void startReplay(replay* r, unsigned int seed, int generation) {
+	r->header.seed = seed;
+	r->header.ticks = 0;
+	r->header.generation = generation;
+	r->header.score = 0;
+}
+
+/**
+ * @brief This function records the move made on the current tick
+ * @param r - the replay
+ * @param move - the snakes move, -1 left, 0 forward, 1 right
+ * @return nothing
+ */
+void recordMove(replay* r, int move) {
+	int byte = r->header.ticks / REPLAY_MOVES_PER_BYTE;
+	int shift = (r->header.ticks % REPLAY_MOVES_PER_BYTE) * 2;
+
+	if (byte >= r->capacity) {
+		r->capacity = r->capacity ? r->capacity * 2 : 256;
+		r->moves = realloc(r->moves, r->capacity);
+	}
+	if (!shift)
+		r->moves[byte] = 0;
+
+	r->moves[byte] |= (move + 1) << shift;
+	r->header.ticks++;
+}
+
+/**
+ * @brief This function stores the final result of the recorded game
+ * @param r - the replay
+ * @param s - the snake at the end of the game
+ * @param b - the board the game was played on
+ * @return nothing
+ */
+void finishReplay(replay* r, snake* s, board* b) {
+	r->header.score = s->score;
+	r->header.width = b->width;
+	r->header.height = b->height;
+}
+
+/**
+ * @brief This function gets the move made on a tick
+ * @param r - the replay
+ * @param tick - the tick, must be less than the replays ticks
+ * @return the move, -1 left, 0 forward, 1 right
+ */
+int getReplayMove(replay* r, int tick) {
+	return ((r->moves[tick / REPLAY_MOVES_PER_BYTE] >> ((tick % REPLAY_MOVES_PER_BYTE) * 2)) & 3) - 1;
+}
+
+/**
+ * @brief This function adds a replay to the end of a replay file, creating it if needed
+ * @param r - the replay
+ * @param filePath - the replay file
+ * @return 1 if all went well, 0 if something went wrong
+ */
+int appendReplay(replay* r, const char* filePath) {
+	FILE* f = fopen(filePath, "ab");
+	if (f == NULL)
+		return 0;
+
+	size_t bytes = (r->header.ticks + REPLAY_MOVES_PER_BYTE - 1) / REPLAY_MOVES_PER_BYTE;
+	int written = fwrite(&r->header, sizeof(replayHeader), 1, f) == 1 && fwrite(r->moves, 1, bytes, f) == bytes;
+
+	fclose(f);
+	return written;
+}
+
+/**
+ * @brief This function reads one replay out of a replay file
+ * @param r - an initialised replay to read into
+ * @param filePath - the replay file
+ * @param index - which replay in the file to read, from 0
+ * @return 1 if all went well, 0 if the file is not a replay file or is too short
+ */
+int loadReplay(replay* r, const char* filePath, int index) {
+	FILE* f = fopen(filePath, "rb");
+	if (f == NULL)
+		return 0;
+
+	int loaded = 0;
+	for (int i = 0; fread(&r->header, sizeof(replayHeader), 1, f) == 1 && r->header.magic == REPLAY_MAGIC; i++) {
+		size_t bytes = (r->header.ticks + REPLAY_MOVES_PER_BYTE - 1) / REPLAY_MOVES_PER_BYTE;
+		if (i < index) {
+			fseek(f, bytes, SEEK_CUR);
+			continue;
+		}
+
+		if (bytes > (size_t)r->capacity) {
+			r->capacity = bytes;
+			r->moves = realloc(r->moves, r->capacity);
+		}
+		loaded = fread(r->moves, 1, bytes, f) == bytes;
+		break;
+	}
+
+	fclose(f);
+	return loaded;
+}
+
+/**
+ * @brief This function counts the replays in a file, only the headers are read
+ * @param filePath - the replay file
+ * @return the number of replays, 0 if it is not a replay file
+ */
+int countReplays(const char* filePath) {
+	FILE* f = fopen(filePath, "rb");
+	if (f == NULL)
+		return 0;
+
+	int count = 0;
+	replayHeader header;
+	while (fread(&header, sizeof(replayHeader), 1, f) == 1 && header.magic == REPLAY_MAGIC) {
+		count++;
+		fseek(f, (header.ticks + REPLAY_MOVES_PER_BYTE - 1) / REPLAY_MOVES_PER_BYTE, SEEK_CUR);
+	}
+
+	fclose(f);
+	return count;
+}
+
+/**
+ * @brief This function puts the game in the state it was in at a given tick, by restarting it from
+ * 		  the seed and replaying the moves without drawing anything.
+ * @param r - the replay
+ * @param s - the snake, initialised by this function
+ * @param b - the board, initialised by this function
+ * @param tick - the tick to stop at, clamped to the length of the replay
+ * @return nothing
+ */
+void seekReplay(replay* r, snake* s, board* b, int tick) {
+	if (tick > (int)r->header.ticks)
+		tick = r->header.ticks;
+
+	initiliseSizedSnakeAndBoard(s, b, r->header.seed, r->header.width, r->header.height);
+	for (int i = 0; i < tick; i++) {
+		s->move = getReplayMove(r, i);
+		updateSnake(s, b);
+	}
+}
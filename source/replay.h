@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+#include "snakeGame.h"
+
+#define REPLAY_MAGIC 0x32524e53		//"SNR2", the board size was added to the header
+#define REPLAY_MOVES_PER_BYTE 4		//each move is 2 bits, 0 left, 1 forward, 2 right
+
+/*
+	A replay file is any number of records appended back to back, each one a replayHeader
+	followed by (ticks + 3) / 4 bytes of packed moves. Given the seed and board size,
+	initiliseSizedSnakeAndBoard and the moves, updateSnake reproduces the game exactly, so no board
+	state is stored.
+*/
+struct replayHeader {
+	uint32_t magic;
+	uint32_t seed;
+	uint32_t ticks;
+	int32_t generation;				//the training generation, or -1 if the game was not from training
+	int32_t score;					//the final score, so replays can be listed without playing them
+	uint8_t width;					//the board the game was played on
+	uint8_t height;
+	uint16_t reserved;
+};
+typedef struct replayHeader replayHeader;
+
+struct replay {
+	replayHeader header;
+	uint8_t* moves;
+	int capacity;					//bytes allocated for moves
+};
+typedef struct replay replay;
+
+void initialiseReplay(replay*);
+void destroyReplay(replay*);
+void startReplay(replay*, unsigned int, int);
+void recordMove(replay*, int);
+void finishReplay(replay*, snake*, board*);
+int getReplayMove(replay*, int);
+int appendReplay(replay*, const char*);
+int loadReplay(replay*, const char*, int);
+int countReplays(const char*);
+void seekReplay(replay*, snake*, board*, int);
@@ -7,13 +7,136 @@
 #include "snakeGraphics.h"
 #include "geneticNeuralNetwork.h"
 
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+//the board size new games are started on, set once from the command line
+static int defaultWidth = BOARD_WIDTH;
+static int defaultHeight = BOARD_HEIGHT;
+
+/*
+	The kernels below take the board size as their last argument. It is either a constant, 8, 16 or
+	32, when the board is square and that size, so every cell index compiles down to shifts and the
+	snakes body is looked up in its bitboard, or 0 for any other board, which scans the body like
+	the game always has. Each public function switches on b->kernel once and calls them with a constant.
+*/
+
+KERNEL_INLINE int onBoard(board* b, int x, int y) {
+	return x >= 0 && x < b->width && y >= 0 && y < b->height;
+}
+
+KERNEL_INLINE int bitboardCell(int x, int y, const int size) {
+	return y * size + x;
+}
+
+KERNEL_INLINE void setBodyCell(snake* s, board* b, int x, int y, const int size) {
+	if (onBoard(b, x, y)) {
+		int cell = bitboardCell(x, y, size);
+		s->body[cell / 64] |= 1ull << (cell % 64);
+	}
+}
+
+KERNEL_INLINE void clearBodyCell(snake* s, board* b, int x, int y, const int size) {
+	if (onBoard(b, x, y)) {
+		int cell = bitboardCell(x, y, size);
+		s->body[cell / 64] &= ~(1ull << (cell % 64));
+	}
+}
+
+/**
+ * @brief This function checks whether a cell on the board is covered by the body, every segment but the head
+ * @param s - the snake
+ * @param x - the x cord of the cell, must be on the board
+ * @param y - the y cord of the cell, must be on the board
+ * @param size - the board size for a bitboard kernel, 0 for the generic one
+ * @return 1 if it is, 0 otherwise
+ */
+KERNEL_INLINE int isBody(snake* s, int x, int y, const int size) {
+	if (size) {
+		int cell = bitboardCell(x, y, size);
+		return (s->body[cell / 64] >> (cell % 64)) & 1;
+	}
+
+	for (int i = 1; i < s->score - s->hasAte; i++)
+		if (x == s->x[i] && y == s->y[i])
+			return 1;
+	return 0;
+}
+
+/**
+ * @brief This function picks the kernel a board is played with and builds the snakes bitboard
+ * 		  from its segments. Only needed when a game is put together by hand rather than started
+ * 		  by initiliseSizedSnakeAndBoard, e.g. from a board sent to the inference daemon.
+ * @param s - the snake
+ * @param b - the board, its size must be set
+ * @return nothing
+ */
+void setBoardKernel(snake* s, board* b) {
+	int size = b->width == b->height ? b->width : 0;
+	b->kernel = size == 8 || size == 16 || size == 32 ? size : BOARD_GENERIC;
+
+	memset(s->body, 0, sizeof(s->body));
+	for (int i = 1; b->kernel && i < s->score - s->hasAte; i++) {
+		int cell = bitboardCell(s->x[i], s->y[i], b->kernel);
+		if (onBoard(b, s->x[i], s->y[i]))
+			s->body[cell / 64] |= 1ull << (cell % 64);
+	}
+}
+
+/**
+ * @brief This function sets the size of the board new games are played on, it has nothing to do
+ * 		  with the size of the window they are drawn in
+ * @param width - the width in cells, clamped to BOARD_MIN_SIZE - BOARD_MAX_SIZE
+ * @param height - the height in cells, clamped the same way
+ * @return nothing
+ */
+void setBoardSize(int width, int height) {
+	defaultWidth = width < BOARD_MIN_SIZE ? BOARD_MIN_SIZE : width > BOARD_MAX_SIZE ? BOARD_MAX_SIZE : width;
+	defaultHeight = height < BOARD_MIN_SIZE ? BOARD_MIN_SIZE : height > BOARD_MAX_SIZE ? BOARD_MAX_SIZE : height;
+}
+
+/**
+ * @brief This function gets the size of the board new games are played on
+ * @param width - where the width is stored
+ * @param height - where the height is stored
+ * @return nothing
+ */
+void getBoardSize(int* width, int* height) {
+	*width = defaultWidth;
+	*height = defaultHeight;
+}
+
 /**
- * @brief This function resets the boards and snake values.
+ * @brief This function resets the boards and snake values, with a random seed.
  * @param s - the snake
  * @param b - the board
  * @return nothing
  */
 void initiliseSnakeAndBoard(snake* s, board* b) {
+	initiliseSeededSnakeAndBoard(s, b, rand());
+}
+
+/**
+ * @brief This function resets the boards and snake values, the food positions (and so the whole
+ * 		  game, given the same moves) are decided by the seed. The board is the size set by setBoardSize.
+ * @param s - the snake
+ * @param b - the board
+ * @param seed - the seed for the food placement
+ * @return nothing
+ */
+void initiliseSeededSnakeAndBoard(snake* s, board* b, unsigned int seed) {
+	initiliseSizedSnakeAndBoard(s, b, seed, defaultWidth, defaultHeight);
+}
+
+/**
+ * @brief This function resets the boards and snake values on a board of a given size
+ * @param s - the snake
+ * @param b - the board
+ * @param seed - the seed for the food placement
+ * @param width - the width of the board in cells
+ * @param height - the height of the board in cells
+ * @return nothing
+ */
+void initiliseSizedSnakeAndBoard(snake* s, board* b, unsigned int seed, int width, int height) {
     s->x = calloc((1) + 2, sizeof(int));	//x-cords
     s->y = calloc((1) + 2, sizeof(int)); 	//y-cords
     s->score = 1; 				    	//score
@@ -21,15 +144,25 @@ void initiliseSnakeAndBoard(snake* s, board* b) {
     s->alive = 1; 						//alive
     s->direction = 0; 						//direction
     s->hasAte = 0;						//hasAte
+	s->death = DEATH_NONE;
 
-	b->height = HEIGHT/GRID_SIZE; 
-    b->width = WIDTH/GRID_SIZE;
+	b->height = height;
+    b->width = width;
+	b->seed = seed;
+	setBoardKernel(s, b);
     placeFood(b, s);
 
 	s->x[0] = b->width/(2);
 	s->y[0] = b->height/(2);
 }
 
+KERNEL_INLINE void placeFoodKernel(board* b, snake* s, const int size) {
+	do {
+		b->foodX = rand_r(&b->seed) % (b->width);
+		b->foodY = rand_r(&b->seed) % (b->height);
+	} while ((b->foodX == s->x[0] && b->foodY == s->y[0]) || isBody(s, b->foodX, b->foodY, size));
+}
+
 /**
  * @brief This function places food on the board, but not on the snake
  * @param b - the board, where the food is placed to.
@@ -37,18 +170,25 @@ void initiliseSnakeAndBoard(snake* s, board* b) {
  * @return nothing
  */
 void placeFood(board* b, snake* s) {
-	int isInSnake;
-	do {
-		isInSnake = 0;
-		b->foodX = rand() % (b->width);
-		b->foodY = rand() % (b->height);
-		for (int i = 0; i < s->score - s->hasAte; i++) {
-			if (b->foodX == s->x[i] && b->foodY == s->y[i]) {
-				isInSnake = 1;
-				break;
-			}
-		}
-	} while (isInSnake);
+	switch (b->kernel) {
+	case 8:
+		placeFoodKernel(b, s, 8);
+		break;
+	case 16:
+		placeFoodKernel(b, s, 16);
+		break;
+	case 32:
+		placeFoodKernel(b, s, 32);
+		break;
+	default:
+		placeFoodKernel(b, s, 0);
+	}
+}
+
+KERNEL_INLINE int collisionKernel(snake* s, board* b, const int size) {
+	if (!onBoard(b, s->x[0], s->y[0]))
+		return 1;
+	return isBody(s, s->x[0], s->y[0], size);
 }
 
 /**
@@ -57,14 +197,15 @@ void placeFood(board* b, snake* s) {
  * @return 1 if the snake has collided with itself, 0 otherwise
  */
 int snakeCollison(snake* s, board* b) {
-	for (int i = 1; i < s->score - s->hasAte; i++) 
-		if (s->x[0] == s->x[i] & s->y[0] == s->y[i])
-			return 1;
-
-	if (s->x[0] < 0 | s->x[0] >= b->width | s->y[0] < 0 | s->y[0] >= b->height) 
-		return 1;
-
-	return 0;
+	switch (b->kernel) {
+	case 8:
+		return collisionKernel(s, b, 8);
+	case 16:
+		return collisionKernel(s, b, 16);
+	case 32:
+		return collisionKernel(s, b, 32);
+	}
+	return collisionKernel(s, b, 0);
 }
 
 int snakeFoodCollsion(snake* s, board* b) {
@@ -75,27 +216,48 @@ int snakeFoodCollsion(snake* s, board* b) {
 	return 0;
 }
 
+/**
+ * @brief This function keeps the bitboard in step with the body after the snake has moved. The
+ * 		  old head has become the first body segment, and unless the snake grew the old tail is gone.
+ * @param s - the snake, already moved
+ * @param b - the board
+ * @param length - the length of the snake before it moved
+ * @param size - the board size
+ * @return nothing
+ */
+KERNEL_INLINE void moveBody(snake* s, board* b, int length, const int size) {
+	int newLength = s->score - s->hasAte;
+	if (newLength > 1)
+		setBodyCell(s, b, s->x[1], s->y[1], size);
+	if (newLength == length && length > 1)
+		clearBodyCell(s, b, s->x[length], s->y[length], size);
+}
+
 /*
  * @brief This function updates the snakes position once per "tick", moves each array index one position up, simulating movement
  * @param s - the snake struct
  * @return nothing
  */
 void updateSnake(snake* s, board* b) {
-	if (snakeCollison(s, b)) 
+	if (snakeCollison(s, b)) {
 		s->alive = 0;
+		s->death = onBoard(b, s->x[0], s->y[0]) ? DEATH_BODY : DEATH_WALL;
+	}
 
 	else if (snakeFoodCollsion(s, b)){
 		s->hasAte += 4;
         s->score += 4;
-        s->x = realloc(s->x, s->score*sizeof(int));
-        s->y = realloc(s->y, s->score*sizeof(int));
+		//one spare segment, the shift below writes one past the length
+        s->x = realloc(s->x, (s->score+1)*sizeof(int));
+        s->y = realloc(s->y, (s->score+1)*sizeof(int));
         placeFood(b, s);
 	}
 
 	s->direction = (4 + s->direction + s->move) % 4;
 	s->move = 0;
 
-	for (int i = s->score - s->hasAte; i > 0; i--) {
+	int length = s->score - s->hasAte;
+	for (int i = length; i > 0; i--) {
 		s->x[i] = s->x[i-1];
 		s->y[i] = s->y[i-1];
 	}
@@ -117,4 +279,254 @@ void updateSnake(snake* s, board* b) {
 
 	if (s->hasAte) s->hasAte--;
 	s->time++;
-}
\ No newline at end of file
+
+	switch (b->kernel) {
+	case 8:
+		moveBody(s, b, length, 8);
+		break;
+	case 16:
+		moveBody(s, b, length, 16);
+		break;
+	case 32:
+		moveBody(s, b, length, 32);
+		break;
+	}
+}
+
+//the step each of the 8 rays takes, in the order getInputs has always used, 5 and 6 are the same
+static const int rayX[8] = {1, 0, -1, 0, 1, -1, -1, 1};
+static const int rayY[8] = {0, 1, 0, -1, 1, 1, 1, -1};
+
+/**
+ * @brief This function works out the 16 sensor inputs, the same values getInputs has always
+ * 		  produced but without copying the snake. The food rays are solved directly, the body rays
+ * 		  march out cell by cell checking the bitboard.
+ * @param s - the snake
+ * @param b - the board
+ * @param inputs - where the 16 inputs are written
+ * @param size - the board size
+ * @return nothing
+ */
+KERNEL_INLINE void senseKernel(snake* s, board* b, double* inputs, const int size) {
+	int headX = s->x[0];
+	int headY = s->y[0];
+	int maxDistance[] = {
+		(b->width - headX) + 1,
+		(b->height - headY) + 1,
+		headX + 1,
+		headY + 1
+	};
+
+	for (int i = s->direction; i < s->direction + 8; i++) {
+		int dx = rayX[i%8];
+		int dy = rayY[i%8];
+		int limit = maxDistance[i%4];
+
+		//the food is n steps along the ray if both cords line up after the same n
+		int n = dx ? (b->foodX - headX) * dx : (b->foodY - headY) * dy;
+		int onRay = n >= 1 && headX + n*dx == b->foodX && headY + n*dy == b->foodY;
+		inputs[i - s->direction] = onRay && n < limit ? n : 0;
+
+		double distance = 0;
+		int x = headX;
+		int y = headY;
+		while (distance < limit) {
+			x += dx;
+			y += dy;
+			distance++;
+			if (!onBoard(b, x, y) || isBody(s, x, y, size))
+				break;
+		}
+		inputs[8 + (i - s->direction)] = 1/distance;
+	}
+}
+
+/**
+ * @brief This function works out the 16 network inputs for the current state of a game
+ * @param s - the snake
+ * @param b - the board
+ * @param inputs - where the 16 inputs are written
+ * @return nothing
+ */
+void senseBoard(snake* s, board* b, double* inputs) {
+	switch (b->kernel) {
+	case 8:
+		senseKernel(s, b, inputs, 8);
+		break;
+	case 16:
+		senseKernel(s, b, inputs, 16);
+		break;
+	case 32:
+		senseKernel(s, b, inputs, 32);
+		break;
+	default:
+		senseKernel(s, b, inputs, 0);
+	}
+}
+
+/**
+ * @brief This function copies the drawable state of a game into a snapshot
+ * @param s - the snake
+ * @param b - the board
+ * @param snapshot - where the state is copied to
+ * @return nothing
+ */
+void takeSnapshot(snake* s, board* b, boardSnapshot* snapshot) {
+	int length = s->score - s->hasAte;
+	if (length > SNAPSHOT_MAX_CELLS)
+		length = SNAPSHOT_MAX_CELLS;
+
+	snapshot->width = b->width;
+	snapshot->height = b->height;
+	snapshot->foodX = b->foodX;
+	snapshot->foodY = b->foodY;
+	snapshot->score = s->score;
+	snapshot->time = s->time;
+	snapshot->alive = s->alive;
+	snapshot->length = length;
+	for (int i = 0; i < length; i++) {
+		snapshot->x[i] = s->x[i];
+		snapshot->y[i] = s->y[i];
+	}
+}
+
+//the step each direction takes, 0 right, 1 down, 2 left, 3 up
+static const int stepX[4] = {1, 0, -1, 0};
+static const int stepY[4] = {0, 1, 0, -1};
+
+static inline int stateOnBoard(const gameState* g, int x, int y) {
+	return x >= 0 && x < g->width && y >= 0 && y < g->height;
+}
+
+static inline int stateIsBody(const gameState* g, int x, int y) {
+	return (g->body[y] >> x) & 1;
+}
+
+static inline int getStateLink(const gameState* g, int x, int y) {
+	int cell = y * GAME_STATE_ROW + x;
+	return (g->links[cell / 4] >> (cell % 4 * 2)) & 3;
+}
+
+static inline void setStateLink(gameState* g, int x, int y, int direction) {
+	int cell = y * GAME_STATE_ROW + x;
+	g->links[cell / 4] = (g->links[cell / 4] & ~(3 << (cell % 4 * 2))) | direction << (cell % 4 * 2);
+}
+
+/**
+ * @brief This function copies a game into a game state, see snakeGame.h
+ * @param s - the snake, it isn't changed
+ * @param b - the board, it isn't changed
+ * @param g - where the state is stored
+ * @return nothing
+ */
+void captureGameState(snake* s, board* b, gameState* g) {
+	int length = s->score - s->hasAte;
+	memset(g->body, 0, sizeof(g->body));
+	g->width = b->width;
+	g->height = b->height;
+	g->headX = s->x[0];
+	g->headY = s->y[0];
+	g->tailX = s->x[length-1];
+	g->tailY = s->y[length-1];
+	g->foodX = b->foodX;
+	g->foodY = b->foodY;
+	g->score = s->score;
+	g->hasAte = s->hasAte;
+	g->time = s->time;
+	g->direction = s->direction;
+
+	//only the head can be off the board, and only on the tick it hits a wall
+	for (int i = 1; i < length; i++) {
+		int dx = s->x[i-1] - s->x[i];
+		int dy = s->y[i-1] - s->y[i];
+		g->body[s->y[i]] |= 1ull << s->x[i];
+		setStateLink(g, s->x[i], s->y[i], dx == 1 ? 0 : dy == 1 ? 1 : dx == -1 ? 2 : 3);
+	}
+	g->alive = s->alive && stateOnBoard(g, g->headX, g->headY) && !stateIsBody(g, g->headX, g->headY);
+}
+
+/**
+ * @brief This function plays one tick of a game state, the same tick updateSnake plays. A snake
+ * 		  that moves onto a wall or its body dies straight away, rather than on the next tick.
+ * @param g - the state
+ * @param move - 0 forward, 1 turn right, -1 turn left
+ * @return nothing
+ */
+void stepGameState(gameState* g, int move) {
+	if (!g->alive)
+		return;
+
+	if (g->headX == g->foodX && g->headY == g->foodY) {
+		g->hasAte += 4;
+		g->score += 4;
+		g->foodX = g->foodY = -1;
+	}
+
+	g->direction = (4 + g->direction + move) % 4;
+	int length = g->score - g->hasAte;
+	if (g->hasAte)
+		g->hasAte--;
+	int newLength = g->score - g->hasAte;
+	int x = g->headX + stepX[g->direction];
+	int y = g->headY + stepY[g->direction];
+
+	//the old head becomes the first body segment, and unless the snake grew the tail moves up
+	if (newLength > 1) {
+		g->body[g->headY] |= 1ull << g->headX;
+		setStateLink(g, g->headX, g->headY, g->direction);
+	}
+	if (newLength == length && length > 1) {
+		int direction = getStateLink(g, g->tailX, g->tailY);
+		g->body[g->tailY] &= ~(1ull << g->tailX);
+		g->tailX += stepX[direction];
+		g->tailY += stepY[direction];
+	} else if (newLength == 1) {
+		g->tailX = x;
+		g->tailY = y;
+	}
+
+	g->headX = x;
+	g->headY = y;
+	g->time++;
+	g->alive = stateOnBoard(g, x, y) && !stateIsBody(g, x, y);
+}
+
+/**
+ * @brief This function works out the 16 network inputs of a game state, the same inputs
+ * 		  senseBoard gives for the game it was taken from. There are no food inputs once the food is eaten.
+ * @param g - the state
+ * @param inputs - where the 16 inputs are written
+ * @return nothing
+ */
+void senseGameState(const gameState* g, double* inputs) {
+	int headX = g->headX;
+	int headY = g->headY;
+	int maxDistance[] = {
+		(g->width - headX) + 1,
+		(g->height - headY) + 1,
+		headX + 1,
+		headY + 1
+	};
+
+	for (int i = g->direction; i < g->direction + 8; i++) {
+		int dx = rayX[i%8];
+		int dy = rayY[i%8];
+		int limit = maxDistance[i%4];
+
+		int n = dx ? (g->foodX - headX) * dx : (g->foodY - headY) * dy;
+		int onRay = g->foodX >= 0 && n >= 1 && headX + n*dx == g->foodX && headY + n*dy == g->foodY;
+		inputs[i - g->direction] = onRay && n < limit ? n : 0;
+
+		double distance = 0;
+		int x = headX;
+		int y = headY;
+		while (distance < limit) {
+			x += dx;
+			y += dy;
+			distance++;
+			if (!stateOnBoard(g, x, y) || stateIsBody(g, x, y))
+				break;
+		}
+		inputs[8 + (i - g->direction)] = 1/distance;
+	}
+}
@@ -1,9 +1,27 @@
 #pragma once
+#include <stdint.h>
+
 #define HEIGHT 600
 #define WIDTH 600
 
 #define GRID_SIZE 20
 
+//the logical board, in cells, is separate from the window and can be changed with setBoardSize
+#define BOARD_WIDTH (WIDTH/GRID_SIZE)
+#define BOARD_HEIGHT (HEIGHT/GRID_SIZE)
+#define BOARD_MIN_SIZE 4
+#define BOARD_MAX_SIZE 64				//so every board fits in a boardSnapshot
+
+#define BOARD_GENERIC 0					//b->kernel of a board without a specialised kernel
+#define BITBOARD_WORDS 16				//enough bits for a 32x32 board, the largest with a bitboard kernel
+
+enum deathCause {
+	DEATH_NONE,			//alive, or starved if the game is over
+	DEATH_WALL,
+	DEATH_BODY
+};
+typedef enum deathCause deathCause;
+
 struct snake {
 	int* x;
 	int* y;
@@ -13,6 +31,8 @@ struct snake {
 	int direction; 		//0-right, 1-down, 2-left, 3-up
 	int move;			//0-forward, 1-turn right, -1-turn left
 	int hasAte;
+	deathCause death;	//what the snake hit, set when it dies
+	uint64_t body[BITBOARD_WORDS];	//one bit per cell covered by a segment other than the head, on 8x8, 16x16 and 32x32 boards
 };
 typedef struct snake snake;
 
@@ -21,11 +41,73 @@ struct board {
 	int width;
 	int foodX;
 	int foodY;
+	unsigned int seed;	//food placement rng state, the same seed always plays the same game
+	int kernel;			//8, 16 or 32 if the board is played with that sizes bitboard kernel, otherwise BOARD_GENERIC
 };
 typedef struct board board;
 
+#define SNAPSHOT_MAX_CELLS 4096		//longest snake a snapshot holds, the whole of a 64x64 board
+
+/*
+	A copy of everything needed to draw a game, with no pointers, so it can be handed
+	between threads or processes with a plain memcpy. Coordinates are stored as bytes,
+	an off board head (the tick a snake hits a wall) wraps past the board size and is skipped.
+*/
+struct boardSnapshot {
+	int32_t width;
+	int32_t height;
+	int32_t foodX;
+	int32_t foodY;
+	int32_t score;
+	int32_t time;
+	int32_t alive;
+	int32_t length;				//segments in x and y, head first
+	uint8_t x[SNAPSHOT_MAX_CELLS];
+	uint8_t y[SNAPSHOT_MAX_CELLS];
+};
+typedef struct boardSnapshot boardSnapshot;
+
+#define GAME_STATE_ROW 64			//cells in each row of a game states body and links, BOARD_MAX_SIZE
+
+/*
+	A game cut down to fixed size arrays, so forking it is one memcpy of about 1.6KB with no
+	allocation. body has a bit per cell covered by a segment other than the head, row y in
+	body[y], and each of those segments keeps the direction (2 bits in links) to the segment in
+	front of it, so the tail can follow the body up without the segments being stored in order.
+	stepGameState plays a tick exactly as updateSnake does. Where food appears next isn't known,
+	so once the food is eaten foodX and foodY are -1.
+*/
+struct gameState {
+	uint64_t body[GAME_STATE_ROW];
+	uint8_t links[GAME_STATE_ROW * GAME_STATE_ROW / 4];
+	int16_t width;
+	int16_t height;
+	int16_t headX;
+	int16_t headY;
+	int16_t tailX;
+	int16_t tailY;
+	int16_t foodX;
+	int16_t foodY;
+	int32_t score;
+	int32_t hasAte;
+	int32_t time;
+	int8_t direction;					//0-right, 1-down, 2-left, 3-up
+	int8_t alive;						//0 as soon as the head is on a wall or the body
+};
+typedef struct gameState gameState;
+
+void setBoardSize(int, int);
+void getBoardSize(int*, int*);
+void setBoardKernel(snake*, board*);
 void initiliseSnakeAndBoard(snake*, board*);
+void initiliseSeededSnakeAndBoard(snake*, board*, unsigned int);
+void initiliseSizedSnakeAndBoard(snake*, board*, unsigned int, int, int);
 void placeFood(board*, snake*);
 int snakeCollison(snake*, board*);
 int snakeFoodCollsion(snake*, board*);
-void updateSnake(snake*, board*);
\ No newline at end of file
+void updateSnake(snake*, board*);
+void senseBoard(snake*, board*, double*);
+void takeSnapshot(snake*, board*, boardSnapshot*);
+void captureGameState(snake*, board*, gameState*);
+void stepGameState(gameState*, int);
+void senseGameState(const gameState*, double*);
\ No newline at end of file
@@ -2,10 +2,13 @@
 #include <SDL2/SDL_timer.h> 
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_image.h> 
+#include <string.h>
 
 #include "snakeGraphics.h"
 #include "snakeGame.h"
 
+static int buildGlyphAtlas(renderWindow*);
+
 /**
  * @brief This function initilises SDL.
  * @return 0 if there is a failure, 1 if success.
@@ -53,7 +56,65 @@ int initiliseWindow(renderWindow* win, const char* name, int height, int width)
 	if (win->font == NULL)
 		return 0;
 
-	return 1;
+	win->boardTexture = NULL;
+	win->drawnCells = NULL;
+	win->wantedCells = NULL;
+	win->boardWidth = 0;
+	win->boardHeight = 0;
+	win->cellSize = GRID_SIZE;
+	win->rects = NULL;
+	win->rectCapacity = 0;
+
+	return buildGlyphAtlas(win);
+}
+
+/**
+ * @brief This function renders every printable character into one texture, so drawing text is just
+ * 		  copying rectangles out of it rather than rendering and uploading a new surface every frame.
+ * @param win - the structure containing the window information, its font must be open
+ * @return 1 if all went well, 0 if something went wrong
+ */
+static int buildGlyphAtlas(renderWindow* win) {
+	SDL_Color color = {255, 255, 255, 128};
+	SDL_Surface* glyphs[GLYPH_COUNT];
+	char text[2] = {0};
+	int width = 0;
+	int height = 0;
+
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		text[0] = GLYPH_FIRST + i;
+		glyphs[i] = TTF_RenderText_Blended(win->font, text, color);
+		win->glyphs[i].x = width;
+		win->glyphs[i].y = 0;
+		win->glyphs[i].w = 0;
+		win->glyphs[i].h = 0;
+		if (glyphs[i] == NULL) {
+			TTF_SizeText(win->font, text, &win->glyphs[i].w, &win->glyphs[i].h);
+		} else {
+			win->glyphs[i].w = glyphs[i]->w;
+			win->glyphs[i].h = glyphs[i]->h;
+		}
+		width += win->glyphs[i].w;
+		if (win->glyphs[i].h > height)
+			height = win->glyphs[i].h;
+	}
+
+	SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		if (glyphs[i] == NULL)
+			continue;
+		if (atlas) {
+			SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(glyphs[i], NULL, atlas, &win->glyphs[i]);
+		}
+		SDL_FreeSurface(glyphs[i]);
+	}
+	if (atlas == NULL)
+		return 0;
+
+	win->glyphAtlas = SDL_CreateTextureFromSurface(win->renderer, atlas);
+	SDL_FreeSurface(atlas);
+	return win->glyphAtlas != NULL;
 }
 
 /**
@@ -62,14 +123,30 @@ int initiliseWindow(renderWindow* win, const char* name, int height, int width)
  * @return nothing
  */
 void destroyWindow(renderWindow* win) {
+	SDL_DestroyTexture(win->boardTexture);
+	SDL_DestroyTexture(win->glyphAtlas);
 	SDL_DestroyRenderer(win->renderer);
 	SDL_DestroyWindow(win->window);
 	TTF_CloseFont(win->font);
+	free(win->drawnCells);
+	free(win->wantedCells);
+	free(win->rects);
 	free(win);
 }
 
 /**
- * @brief This function draws text to the given window
+ * @brief This function forgets what the cached board shows, so the next frame redraws every cell.
+ * 		  Needed after SDL_RENDER_TARGETS_RESET, when the contents of target textures are lost.
+ * @param win - the structure containing the window information.
+ * @return nothing
+ */
+void invalidateBoard(renderWindow* win) {
+	if (win->drawnCells)
+		memset(win->drawnCells, 0xff, win->boardWidth * win->boardHeight);
+}
+
+/**
+ * @brief This function draws text to the given window, one copy out of the glyph atlas per character
  * @param win - A struct containing the window and rendering details
  * @param text - The text to be written to the renderer
  * @param x - the x cord of the text
@@ -77,20 +154,65 @@ void destroyWindow(renderWindow* win) {
  * @return nothing
  */
 void drawText(renderWindow* win, const char* text, int x, int y) {
-	SDL_Color color = {255, 255, 255, 128};
+	for (; *text; text++) {
+		int glyph = (unsigned char)*text - GLYPH_FIRST;
+		if (glyph < 0 || glyph >= GLYPH_COUNT)
+			glyph = '?' - GLYPH_FIRST;
+
+		SDL_Rect textBox = {x, y, win->glyphs[glyph].w, win->glyphs[glyph].h};
+		SDL_RenderCopy(win->renderer, win->glyphAtlas, &win->glyphs[glyph], &textBox);
+		x += textBox.w;
+	}
+}
+
+/**
+ * @brief This function makes sure the rect scratch space can hold a given number of rects
+ * @param win - A struct containing the window and rendering details
+ * @param count - the number of rects needed
+ * @return nothing
+ */
+static void reserveRects(renderWindow* win, int count) {
+	if (count <= win->rectCapacity)
+		return;
+	win->rectCapacity = count * 2;
+	win->rects = realloc(win->rects, win->rectCapacity * sizeof(SDL_Rect));
+}
 
-	win->surface = TTF_RenderText_Solid(win->font, text, color);
-	win->texture = SDL_CreateTextureFromSurface(win->renderer, win->surface);
+/**
+ * @brief This function sets up the cached board texture for a board size, every cell starts out
+ * 		  unknown so the first frame draws all of them
+ * @param win - A struct containing the window and rendering details
+ * @param b - the game board.
+ * @return nothing
+ */
+static void resizeBoardTexture(renderWindow* win, board* b) {
+	SDL_DestroyTexture(win->boardTexture);
+	win->boardWidth = b->width;
+	win->boardHeight = b->height;
 
-	SDL_Rect textBox;
-	textBox.x = x;
-	textBox.y = y;
+	//the board is scaled to the window, a 30x30 board in the 600x600 window is GRID_SIZE pixels a cell
+	int width, height;
+	if (SDL_GetRendererOutputSize(win->renderer, &width, &height) != 0) {
+		width = WIDTH;
+		height = HEIGHT;
+	}
+	win->cellSize = width / b->width < height / b->height ? width / b->width : height / b->height;
+	if (win->cellSize < 1)
+		win->cellSize = 1;
 
-	SDL_QueryTexture(win->texture, NULL, NULL, &textBox.w, &textBox.h);
-	SDL_RenderCopy(win->renderer, win->texture, NULL, &textBox);
+	win->drawnCells = realloc(win->drawnCells, b->width * b->height);
+	win->wantedCells = realloc(win->wantedCells, b->width * b->height);
+	invalidateBoard(win);
 
-	SDL_DestroyTexture(win->texture);
-	SDL_FreeSurface(win->surface);
+	//without render target support every frame is drawn from scratch instead
+	win->boardTexture = SDL_CreateTexture(win->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+		b->width*win->cellSize, b->height*win->cellSize);
+	if (win->boardTexture) {
+		SDL_SetRenderTarget(win->renderer, win->boardTexture);
+		SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
+		SDL_RenderClear(win->renderer);
+		SDL_SetRenderTarget(win->renderer, NULL);
+	}
 }
 
 /**
@@ -101,17 +223,89 @@ void drawText(renderWindow* win, const char* text, int x, int y) {
  * @param font - the font to be used.
  */
 void renderBoard(renderWindow* win, snake* s, board* b) {
-	SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
-	SDL_RenderClear(win->renderer);
+	drawBoard(win, s, b);
+	SDL_RenderPresent(win->renderer);
+}
 
-	SDL_Rect foodImg = {(b->foodX*GRID_SIZE)-1, (b->foodY*GRID_SIZE)-1, GRID_SIZE-1, GRID_SIZE-1};
-	SDL_SetRenderDrawColor(win->renderer, 0, 255, 0, 0);
-	SDL_RenderFillRect(win->renderer, &foodImg);
+/**
+ * @brief This function draws a list of lines of text down the left of the window, below the score
+ * @param win - A struct containing the window and rendering details
+ * @param lines - the lines of text
+ * @param count - the number of lines
+ * @return nothing
+ */
+void drawOverlay(renderWindow* win, const char** lines, int count) {
+	for (int i = 0; i < count; i++)
+		drawText(win, lines[i], 10, 40 + i*24);
+}
+
+/**
+ * @brief This function draws the board and the score, without presenting it, so more can be drawn on top.
+ * @param win - A struct containing the window and rendering details
+ * @param s - the snake.
+ * @param b - the game board.
+ * @return nothing
+ */
+void drawBoard(renderWindow* win, snake* s, board* b) {
+	if (win->boardWidth != b->width || win->boardHeight != b->height)
+		resizeBoardTexture(win, b);
+
+	int cells = b->width * b->height;
+	int cell = win->cellSize;
+	int length = s->score - s->hasAte;
+
+	if (win->boardTexture == NULL) {
+		SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
+		SDL_RenderClear(win->renderer);
+
+		SDL_Rect foodImg = {(b->foodX*cell)-1, (b->foodY*cell)-1, cell-1, cell-1};
+		SDL_SetRenderDrawColor(win->renderer, 0, 255, 0, 0);
+		SDL_RenderFillRect(win->renderer, &foodImg);
 
-	for (int i = 0; i < s->score - s->hasAte; i++) {
-		SDL_Rect snakeImg = {(s->x[i]*GRID_SIZE)-1, (s->y[i]*GRID_SIZE)-1, GRID_SIZE-1, GRID_SIZE-1};
+		reserveRects(win, length);
+		for (int i = 0; i < length; i++) {
+			SDL_Rect snakeImg = {(s->x[i]*cell)-1, (s->y[i]*cell)-1, cell-1, cell-1};
+			win->rects[i] = snakeImg;
+		}
 		SDL_SetRenderDrawColor(win->renderer, 255, 0, 0, 0);
-		SDL_RenderFillRect(win->renderer, &snakeImg);
+		SDL_RenderFillRects(win->renderer, win->rects, length);
+	} else {
+		//work out what every cell should show, the snake is drawn over the food like before
+		memset(win->wantedCells, 0, cells);
+		if (b->foodX >= 0 && b->foodX < b->width && b->foodY >= 0 && b->foodY < b->height)
+			win->wantedCells[b->foodY * b->width + b->foodX] = 2;
+		for (int i = 0; i < length; i++)
+			if (s->x[i] >= 0 && s->x[i] < b->width && s->y[i] >= 0 && s->y[i] < b->height)
+				win->wantedCells[s->y[i] * b->width + s->x[i]] = 1;
+
+		//then only the cells that differ from the last frame are drawn, one call per colour
+		const Uint8 colours[3][4] = {{0, 0, 0, 255}, {255, 0, 0, 0}, {0, 255, 0, 0}};
+		int counts[3] = {0};
+		reserveRects(win, cells * 3);
+		for (int i = 0; i < cells; i++) {
+			int wanted = win->wantedCells[i];
+			if (wanted == win->drawnCells[i])
+				continue;
+
+			SDL_Rect cellImg = {((i % b->width)*cell)-1, ((i / b->width)*cell)-1, cell-1, cell-1};
+			win->rects[wanted * cells + counts[wanted]++] = cellImg;
+			win->drawnCells[i] = wanted;
+		}
+
+		SDL_SetRenderTarget(win->renderer, win->boardTexture);
+		for (int i = 0; i < 3; i++) {
+			if (!counts[i])
+				continue;
+			SDL_SetRenderDrawColor(win->renderer, colours[i][0], colours[i][1], colours[i][2], colours[i][3]);
+			SDL_RenderFillRects(win->renderer, &win->rects[i * cells], counts[i]);
+		}
+		SDL_SetRenderTarget(win->renderer, NULL);
+
+		//a board that doesn't fill the window leaves a border, which has to be cleared every frame
+		SDL_Rect boardImg = {0, 0, b->width*cell, b->height*cell};
+		SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
+		SDL_RenderClear(win->renderer);
+		SDL_RenderCopy(win->renderer, win->boardTexture, NULL, &boardImg);
 	}
 
 	char temp[256];
@@ -120,7 +314,61 @@ void renderBoard(renderWindow* win, snake* s, board* b) {
 	drawText(win, temp, 10, 10);
 
 	sprintf(temp, "Time: %d", s->time/10);
-	drawText(win, temp, (b->width*GRID_SIZE)-90, 10);
+	drawText(win, temp, (b->width*cell)-90, 10);
+}
 
-	SDL_RenderPresent(win->renderer);
+/**
+ * @brief This function draws many small boards at once, each scaled into its own tile of the current
+ * 		  render target. All the backgrounds, all the food and all the snakes are drawn in one call
+ * 		  each, however many boards there are.
+ * @param win - A struct containing the window and rendering details
+ * @param snapshots - the boards to draw
+ * @param tiles - where each board is drawn
+ * @param count - the number of boards
+ * @return nothing
+ */
+void drawSnapshots(renderWindow* win, boardSnapshot** snapshots, const SDL_Rect* tiles, int count) {
+	int total = count * 2;
+	for (int i = 0; i < count; i++)
+		total += snapshots[i]->length;
+	reserveRects(win, total);
+
+	SDL_Rect* backgrounds = win->rects;
+	SDL_Rect* food = backgrounds + count;
+	SDL_Rect* bodies = food + count;
+	int foodCount = 0;
+	int bodyCount = 0;
+
+	for (int i = 0; i < count; i++) {
+		boardSnapshot* snap = snapshots[i];
+		backgrounds[i] = tiles[i];
+		if (snap->width <= 0 || snap->height <= 0)
+			continue;
+
+		//whole pixels per cell, so every cell of a board is the same size, centred in the tile
+		int cell = tiles[i].w / snap->width < tiles[i].h / snap->height ? tiles[i].w / snap->width : tiles[i].h / snap->height;
+		if (cell < 1)
+			cell = 1;
+		int gap = cell > 3;
+		int left = tiles[i].x + (tiles[i].w - cell * snap->width) / 2;
+		int top = tiles[i].y + (tiles[i].h - cell * snap->height) / 2;
+
+		if (snap->foodX >= 0 && snap->foodX < snap->width && snap->foodY >= 0 && snap->foodY < snap->height) {
+			SDL_Rect foodImg = {left + snap->foodX*cell, top + snap->foodY*cell, cell - gap, cell - gap};
+			food[foodCount++] = foodImg;
+		}
+		for (int j = 0; j < snap->length; j++) {
+			if (snap->x[j] >= snap->width || snap->y[j] >= snap->height)
+				continue;
+			SDL_Rect snakeImg = {left + snap->x[j]*cell, top + snap->y[j]*cell, cell - gap, cell - gap};
+			bodies[bodyCount++] = snakeImg;
+		}
+	}
+
+	SDL_SetRenderDrawColor(win->renderer, 0, 0, 0, 255);
+	SDL_RenderFillRects(win->renderer, backgrounds, count);
+	SDL_SetRenderDrawColor(win->renderer, 0, 255, 0, 0);
+	SDL_RenderFillRects(win->renderer, food, foodCount);
+	SDL_SetRenderDrawColor(win->renderer, 255, 0, 0, 0);
+	SDL_RenderFillRects(win->renderer, bodies, bodyCount);
 }
\ No newline at end of file
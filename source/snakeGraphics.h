@@ -5,12 +5,24 @@
 
 #include "snakeGame.h"
 
+#define GLYPH_FIRST 32			//the first printable ascii character, space
+#define GLYPH_COUNT 95			//space to ~
+
 struct renderWindow {
 	SDL_Window* window; 			//The physical window that everything is displayed to
 	SDL_Renderer* renderer;			//The renderer that renders pixels to the window above
-	SDL_Surface* surface;			//A surface to use, used for text in this program
-	SDL_Texture* texture;			//A texture to use, used for text in this program 
+	SDL_Texture* glyphAtlas;		//Every printable character, rendered once when the window is made
+	SDL_Rect glyphs[GLYPH_COUNT];	//Where each character is in the atlas
 	TTF_Font* font;					//A true text font to be used
+
+	SDL_Texture* boardTexture;		//The board as it was last drawn, only the cells that change are redrawn
+	unsigned char* drawnCells;		//What each cell of boardTexture shows, 0 empty, 1 snake, 2 food
+	unsigned char* wantedCells;		//What each cell should show this frame
+	int boardWidth;					//The board boardTexture was made for
+	int boardHeight;
+	int cellSize;					//Pixels per board cell, so the whole board fits the window
+	SDL_Rect* rects;				//Scratch space, so a whole colour can be drawn in one call
+	int rectCapacity;
 };
 typedef struct renderWindow renderWindow;
 
@@ -19,4 +31,8 @@ void destroySDL();
 int initiliseWindow(renderWindow*, const char*, int, int);
 void drawText(renderWindow*, const char*, int, int);
 void renderBoard(renderWindow*, snake*, board*);
-void destroyWindow(renderWindow*);
\ No newline at end of file
+void drawBoard(renderWindow*, snake*, board*);
+void drawOverlay(renderWindow*, const char**, int);
+void drawSnapshots(renderWindow*, boardSnapshot**, const SDL_Rect*, int);
+void destroyWindow(renderWindow*);
+void invalidateBoard(renderWindow*);
\ No newline at end of file
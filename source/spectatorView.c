@@ -0,0 +1,591 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "spectatorView.h"
+#include "frameScheduler.h"
+#include "geneticNeuralNetwork.h"
+
+#define SPECTATOR_MAX_LAG 250000000LL		//ns a worker can fall behind before it stops trying to catch up
+
+struct spectatorWorker {
+	spectator* v;
+	int first;						//the worker plays boards first, first + workerCount, ...
+};
+typedef struct spectatorWorker spectatorWorker;
+
+/**
+ * @brief This function compares two brain paths for qsort, runs of digits are compared by their
+ * 		  value so Generation_2 comes before Generation_10
+ * @param a - a path
+ * @param b - another path
+ * @return less than, equal to or greater than 0 as a comes before, with or after b
+ */
+static int compareNames(const void* a, const void* b) {
+	const char* x = *(char* const*)a;
+	const char* y = *(char* const*)b;
+
+	while (*x && *y) {
+		if (isdigit((unsigned char)*x) && isdigit((unsigned char)*y)) {
+			char* xEnd;
+			char* yEnd;
+			unsigned long long xNumber = strtoull(x, &xEnd, 10);
+			unsigned long long yNumber = strtoull(y, &yEnd, 10);
+			if (xNumber != yNumber)
+				return xNumber < yNumber ? -1 : 1;
+			x = xEnd;
+			y = yEnd;
+		} else {
+			if (*x != *y)
+				return (unsigned char)*x - (unsigned char)*y;
+			x++;
+			y++;
+		}
+	}
+	return (unsigned char)*x - (unsigned char)*y;
+}
+
+/**
+ * @brief This function reads the monotonic clock
+ * @return the time in nanoseconds
+ */
+static long long monotonicNanoseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief This function gives every board a brain out of a directory, boards are dealt the brains in
+ * 		  name order and share them round robin if there are more boards than brains
+ * @param v - the spectator, its boards are allocated
+ * @param directory - the directory holding the brain files
+ * @return the number of different brains being watched, 0 if there were none
+ */
+static int loadBrainDirectory(spectator* v, const char* directory) {
+	DIR* dir = opendir(directory);
+	if (dir == NULL)
+		return 0;
+
+	int count = 0;
+	int capacity = 64;
+	char** names = malloc(capacity * sizeof(char*));
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != NULL) {
+		char path[4096];
+		struct stat info;
+		snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+		if (entry->d_name[0] == '.' || stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+			continue;
+
+		//brains share the directory with replay files, mapBrain only keeps brains that can play
+		neuralNetwork nn;
+		if (!mapBrain(&nn, path))
+			continue;
+		destroyBrainData(&nn);
+
+		if (count == capacity) {
+			capacity *= 2;
+			names = realloc(names, capacity * sizeof(char*));
+		}
+		names[count++] = strdup(path);
+	}
+	closedir(dir);
+	qsort(names, count, sizeof(char*), compareNames);
+
+	int loaded = 0;
+	for (int i = 0; i < v->boardCount && count; i++)
+		if ((v->boards[i].hasBrain = mapBrain(&v->boards[i].nn, names[i % count])))
+			loaded++;
+
+	for (int i = 0; i < count; i++)
+		free(names[i]);
+	free(names);
+	return loaded < count ? loaded : count;
+}
+
+/**
+ * @brief This function loads the most recent replays in a file, one per board, boards share them
+ * 		  round robin if there are more boards than replays
+ * @param v - the spectator, its boards are allocated
+ * @param path - the replay file
+ * @return the number of replays loaded, 0 if it isn't a replay file
+ */
+static int loadReplayFile(spectator* v, const char* path) {
+	int count = countReplays(path);
+	if (count > v->boardCount)
+		count = v->boardCount;
+	if (!count)
+		return 0;
+
+	int first = countReplays(path) - count;
+	v->replays = calloc(count, sizeof(replay));
+	for (int i = 0; i < count; i++) {
+		initialiseReplay(&v->replays[v->replayCount]);
+		if (loadReplay(&v->replays[v->replayCount], path, first + i))
+			v->replayCount++;
+		else
+			destroyReplay(&v->replays[v->replayCount]);
+	}
+
+	for (int i = 0; i < v->boardCount && v->replayCount; i++)
+		v->boards[i].r = &v->replays[i % v->replayCount];
+	return v->replayCount;
+}
+
+/**
+ * @brief This function starts a new game on a board, a replay starts again from its first tick and
+ * 		  a brain gets a new seed
+ * @param sb - the board
+ * @return nothing
+ */
+static void startBoardGame(spectatorBoard* sb) {
+	if (sb->r) {
+		seekReplay(sb->r, &sb->s, &sb->b, 0);
+		sb->tick = 0;
+	} else {
+		initiliseSeededSnakeAndBoard(&sb->s, &sb->b, rand_r(&sb->random));
+		sb->ticksSinceAteFood = 100;
+	}
+}
+
+/**
+ * @brief This function plays one tick of a board, the same way test mode and replay mode do, and
+ * 		  starts the next game on the tick after one ends so the final position is seen
+ * @param sb - the board
+ * @return nothing
+ */
+static void stepBoard(spectatorBoard* sb) {
+	snake* s = &sb->s;
+	board* b = &sb->b;
+	int over;
+
+	if (sb->r) {
+		over = sb->tick >= (int)sb->r->header.ticks;
+		if (!over) {
+			s->move = getReplayMove(sb->r, sb->tick++);
+			updateSnake(s, b);
+		}
+	} else {
+		over = !s->alive || sb->ticksSinceAteFood <= 0;
+		if (!over) {
+			int startBudget, foodBudget;
+			getStarvationBudget(&startBudget, &foodBudget);
+			if (s->x[0] == b->foodX && s->y[0] == b->foodY)
+				sb->ticksSinceAteFood += foodBudget;
+
+			getInputs(&sb->nn, s, b);
+			frontPropegation(&sb->nn, 0);
+			s->move = getOutput(&sb->nn) - 1;		//nn outputs 0 for left, 1 for forward, 2 for right, one more than the game;
+			updateSnake(s, b);
+			sb->ticksSinceAteFood--;
+		}
+	}
+
+	if (over) {
+		free(s->x);
+		free(s->y);
+		startBoardGame(sb);
+	}
+}
+
+/**
+ * @brief This function hands the current state of a board to the renderer, it never waits
+ * @param sb - the board
+ * @return nothing
+ */
+static void publishSnapshot(spectatorBoard* sb) {
+	takeSnapshot(&sb->s, &sb->b, &sb->snapshots[sb->writing]);
+	sb->writing = atomic_exchange(&sb->ready, sb->writing | SPECTATOR_FRESH) & 3;
+}
+
+/**
+ * @brief This function picks up the latest snapshot of a board, if there is a new one
+ * @param sb - the board
+ * @return 1 if snapshots[reading] changed, 0 otherwise
+ */
+static int consumeSnapshot(spectatorBoard* sb) {
+	if (!(atomic_load(&sb->ready) & SPECTATOR_FRESH))
+		return 0;
+	sb->reading = atomic_exchange(&sb->ready, sb->reading) & 3;
+	return 1;
+}
+
+/**
+ * @brief This function sleeps a worker while the game is paused, and until its next tick is due
+ * 		  when the game is throttled. Changing the speed, pausing or closing wakes it straight away.
+ * @param v - the spectator
+ * @param deadline - when the last tick was due, moved on to when the next one is
+ * @return nothing
+ */
+static void waitForSpectatorTick(spectator* v, long long* deadline) {
+	pthread_mutex_lock(&v->lock);
+	while (atomic_load(&v->running) && atomic_load(&v->paused)) {
+		pthread_cond_wait(&v->changed, &v->lock);
+		*deadline = monotonicNanoseconds();
+	}
+
+	long long interval = atomic_load(&v->tickNanoseconds);
+	if (interval > 0) {
+		long long now = monotonicNanoseconds();
+		*deadline += interval;
+		if (*deadline < now - SPECTATOR_MAX_LAG)
+			*deadline = now;
+
+		while (now < *deadline && atomic_load(&v->running) && !atomic_load(&v->paused) && atomic_load(&v->tickNanoseconds) == interval) {
+			struct timespec until = {*deadline / 1000000000LL, *deadline % 1000000000LL};
+			if (pthread_cond_timedwait(&v->changed, &v->lock, &until) == ETIMEDOUT)
+				break;
+			now = monotonicNanoseconds();
+		}
+	}
+	pthread_mutex_unlock(&v->lock);
+}
+
+/**
+ * @brief This function is run by each worker thread, it ticks its share of the boards together
+ * @param arg - the spectatorWorker
+ * @return nothing
+ */
+static void* spectatorWorkerThread(void* arg) {
+	spectatorWorker* w = arg;
+	spectator* v = w->v;
+	long long deadline = monotonicNanoseconds();
+
+	while (atomic_load(&v->running)) {
+		//unthrottled, only the atomics are checked, so the workers never queue up on the lock
+		if (atomic_load(&v->paused) || atomic_load(&v->tickNanoseconds) > 0)
+			waitForSpectatorTick(v, &deadline);
+		if (!atomic_load(&v->running) || atomic_load(&v->paused))
+			continue;
+
+		int stepped = 0;
+		for (int i = w->first; i < v->boardCount; i += v->workerCount) {
+			spectatorBoard* sb = &v->boards[i];
+			if (!sb->hasBrain && !sb->r)
+				continue;
+			stepBoard(sb);
+			publishSnapshot(sb);
+			stepped++;
+		}
+		atomic_fetch_add(&v->ticks, stepped);
+	}
+	return NULL;
+}
+
+/**
+ * @brief This function changes how fast every board is played
+ * @param v - the spectator
+ * @param speed - multiplies SPECTATOR_TICKS_PER_SECOND
+ * @param unthrottled - if 1 the boards are played as fast as the workers can go
+ * @return nothing
+ */
+static void setSpectatorSpeed(spectator* v, double speed, int unthrottled) {
+	pthread_mutex_lock(&v->lock);
+	atomic_store(&v->tickNanoseconds, unthrottled ? 0 : (long long)(1e9 / (SPECTATOR_TICKS_PER_SECOND * speed)));
+	pthread_cond_broadcast(&v->changed);
+	pthread_mutex_unlock(&v->lock);
+}
+
+/**
+ * @brief This function pauses or unpauses every board
+ * @param v - the spectator
+ * @param paused - 1 to pause
+ * @return nothing
+ */
+static void setSpectatorPaused(spectator* v, int paused) {
+	pthread_mutex_lock(&v->lock);
+	atomic_store(&v->paused, paused);
+	pthread_cond_broadcast(&v->changed);
+	pthread_mutex_unlock(&v->lock);
+}
+
+/**
+ * @brief This function stops the workers and frees the boards
+ * @param v - the spectator
+ * @return nothing
+ */
+static void closeSpectator(spectator* v) {
+	pthread_mutex_lock(&v->lock);
+	atomic_store(&v->running, 0);
+	pthread_cond_broadcast(&v->changed);
+	pthread_mutex_unlock(&v->lock);
+
+	for (int i = 0; i < v->workerCount; i++)
+		pthread_join(v->workers[i], NULL);
+
+	for (int i = 0; i < v->boardCount; i++) {
+		spectatorBoard* sb = &v->boards[i];
+		if (sb->hasBrain)
+			destroyBrainData(&sb->nn);
+		if (sb->hasBrain || sb->r) {
+			free(sb->s.x);
+			free(sb->s.y);
+		}
+	}
+	for (int i = 0; i < v->replayCount; i++)
+		destroyReplay(&v->replays[i]);
+
+	pthread_cond_destroy(&v->changed);
+	pthread_mutex_destroy(&v->lock);
+	free(v->workers);
+	free(v->replays);
+	free(v->boards);
+}
+
+/**
+ * @brief This function loads what is going to be watched and starts the worker threads
+ * @param v - the spectator
+ * @param source - a directory of brains, a replay file or a single brain
+ * @param boardCount - the number of boards
+ * @param workers - where the workers arguments are stored, one per core
+ * @return 1 if all went well, 0 if there was nothing to watch
+ */
+static int openSpectator(spectator* v, const char* source, int boardCount, spectatorWorker** workers) {
+	memset(v, 0, sizeof(spectator));
+	v->boardCount = boardCount;
+	v->boards = calloc(boardCount, sizeof(spectatorBoard));
+
+	//the workers sleep until an absolute time on the monotonic clock
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&v->changed, &attributes);
+	pthread_condattr_destroy(&attributes);
+	pthread_mutex_init(&v->lock, NULL);
+	atomic_init(&v->running, 1);
+	atomic_init(&v->paused, 0);
+	atomic_init(&v->tickNanoseconds, (long long)(1e9 / SPECTATOR_TICKS_PER_SECOND));
+	atomic_init(&v->ticks, 0);
+
+	struct stat info;
+	int sources = 0;
+	if (stat(source, &info) == 0 && S_ISDIR(info.st_mode)) {
+		sources = loadBrainDirectory(v, source);
+		printf("Watching %d brains from %s on %d boards\n", sources, source, boardCount);
+	} else if (countReplays(source)) {
+		sources = loadReplayFile(v, source);
+		printf("Watching %d replays from %s on %d boards\n", sources, source, boardCount);
+	} else {
+		for (int i = 0; i < boardCount; i++)
+			sources += v->boards[i].hasBrain = mapBrain(&v->boards[i].nn, source);
+		sources = sources > 0;
+		printf("Watching %s on %d boards\n", source, boardCount);
+	}
+
+	if (!sources) {
+		printf("Nothing to watch in %s\n", source);
+		closeSpectator(v);
+		return 0;
+	}
+
+	//every board starts with a snapshot the renderer can show before its worker gets to it
+	unsigned int seed = rand();
+	for (int i = 0; i < boardCount; i++) {
+		spectatorBoard* sb = &v->boards[i];
+		sb->writing = 0;
+		atomic_init(&sb->ready, 1);
+		sb->reading = 2;
+		if (sb->hasBrain || sb->r) {
+			sb->random = seed + i;
+			startBoardGame(sb);
+			publishSnapshot(sb);
+			consumeSnapshot(sb);
+		}
+	}
+
+	//the render thread has a core of its own
+	int threads = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	if (threads < 1)
+		threads = 1;
+	if (threads > boardCount)
+		threads = boardCount;
+
+	v->workers = calloc(threads, sizeof(pthread_t));
+	*workers = calloc(threads, sizeof(spectatorWorker));
+	v->workerCount = threads;
+	for (int i = 0; i < threads; i++) {
+		(*workers)[i].v = v;
+		(*workers)[i].first = i;
+		pthread_create(&v->workers[i], NULL, spectatorWorkerThread, &(*workers)[i]);
+	}
+	return 1;
+}
+
+/**
+ * @brief This function shows many games at once, tiled across the window. The games are played by
+ * 		  worker threads and the window only draws the boards that changed since the last frame,
+ * 		  all of them with a handful of draw calls, at up to FRAME_MAX_FPS.
+ * 		  +/- (or up/down) change the speed, 0 runs unthrottled, space pauses and tab shows the stats.
+ * @param win - the window that will be rendered
+ * @param source - a directory of brains, a replay file or a single brain
+ * @param boardCount - the number of boards, between SPECTATOR_MIN_BOARDS and SPECTATOR_MAX_BOARDS
+ * @return 1 when the user quits, 0 if there was nothing to watch
+ */
+int runSpectator(renderWindow* win, const char* source, int boardCount) {
+	if (boardCount < SPECTATOR_MIN_BOARDS)
+		boardCount = SPECTATOR_MIN_BOARDS;
+	if (boardCount > SPECTATOR_MAX_BOARDS)
+		boardCount = SPECTATOR_MAX_BOARDS;
+
+	spectator v;
+	spectatorWorker* workers = NULL;
+	if (!openSpectator(&v, source, boardCount, &workers))
+		return 0;
+
+	int width, height;
+	SDL_GetRendererOutputSize(win->renderer, &width, &height);
+	int columns = 1;
+	while (columns * columns < boardCount)
+		columns++;
+	int rows = (boardCount + columns - 1) / columns;
+
+	//one pixel between the tiles, so the boards can be told apart
+	SDL_Rect* tiles = malloc(boardCount * sizeof(SDL_Rect));
+	for (int i = 0; i < boardCount; i++) {
+		SDL_Rect tile = {(i % columns) * width / columns, (i / columns) * height / rows, 0, 0};
+		tile.w = ((i % columns) + 1) * width / columns - tile.x - 1;
+		tile.h = ((i / columns) + 1) * height / rows - tile.y - 1;
+		tiles[i] = tile;
+	}
+
+	//the tiles are kept in a target texture between frames, without one every tile is drawn every frame
+	SDL_Texture* target = SDL_CreateTexture(win->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+	boardSnapshot** changed = malloc(boardCount * sizeof(boardSnapshot*));
+	SDL_Rect* changedTiles = malloc(boardCount * sizeof(SDL_Rect));
+
+	frameScheduler f;
+	SDL_Event e;
+	double speed = 1;
+	int unthrottled = 0;
+	int showStats = 0;
+	int redrawAll = 1;
+	long long lastTicks = 0;
+	Uint64 lastStats = SDL_GetPerformanceCounter();
+	double ticksPerSecond = 0;
+
+	//the scheduler only paces the renderer, the games are ticked by the workers
+	initialiseFrameScheduler(&f, FRAME_MAX_FPS);
+	while (1) {
+		int quit = 0;
+		while (waitForFrameEvent(&f, &e)) {
+			if (e.type == SDL_QUIT) {
+				quit = 1;
+			} else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+				redrawAll = 1;
+				redrawFrame(&f);
+			} else if (e.type == SDL_KEYDOWN) {
+				switch (e.key.keysym.sym) {
+				case SDLK_EQUALS:
+				case SDLK_PLUS:
+				case SDLK_UP:
+					speed *= 2;
+					if (speed > FRAME_MAX_SPEED) {
+						speed = FRAME_MAX_SPEED;
+						unthrottled = 1;
+					}
+					break;
+				case SDLK_MINUS:
+				case SDLK_DOWN:
+					if (unthrottled)
+						unthrottled = 0;
+					else if (speed > FRAME_MIN_SPEED)
+						speed /= 2;
+					break;
+				case SDLK_0:
+					unthrottled = !unthrottled;
+					break;
+				case SDLK_SPACE:
+					toggleFramePause(&f);
+					setSpectatorPaused(&v, f.paused);
+					continue;
+				case SDLK_TAB:
+					showStats = !showStats;
+					redrawFrame(&f);
+					continue;
+				default:
+					continue;
+				}
+				setSpectatorSpeed(&v, speed, unthrottled);
+				redrawFrame(&f);
+			}
+		}
+		if (quit)
+			break;
+
+		while (nextTick(&f));
+
+		if (!nextRender(&f))
+			continue;
+
+		int count = 0;
+		for (int i = 0; i < boardCount; i++) {
+			spectatorBoard* sb = &v.boards[i];
+			if (consumeSnapshot(sb) || redrawAll || target == NULL) {
+				changed[count] = &sb->snapshots[sb->reading];
+				changedTiles[count++] = tiles[i];
+			}
+		}
+
+		if (target) {
+			SDL_SetRenderTarget(win->renderer, target);
+			if (redrawAll) {
+				SDL_SetRenderDrawColor(win->renderer, 40, 40, 40, 255);
+				SDL_RenderClear(win->renderer);
+			}
+			drawSnapshots(win, changed, changedTiles, count);
+			SDL_SetRenderTarget(win->renderer, NULL);
+			SDL_RenderCopy(win->renderer, target, NULL, NULL);
+		} else {
+			SDL_SetRenderDrawColor(win->renderer, 40, 40, 40, 255);
+			SDL_RenderClear(win->renderer);
+			drawSnapshots(win, changed, changedTiles, count);
+		}
+		redrawAll = 0;
+
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (now - lastStats >= SDL_GetPerformanceFrequency()) {
+			long long ticks = atomic_load(&v.ticks);
+			ticksPerSecond = (ticks - lastTicks) / ((double)(now - lastStats) / SDL_GetPerformanceFrequency());
+			lastTicks = ticks;
+			lastStats = now;
+		}
+
+		if (showStats) {
+			char text[4][64];
+			const char* lines[4];
+			int best = 0;
+			for (int i = 0; i < boardCount; i++)
+				if (v.boards[i].snapshots[v.boards[i].reading].score > best)
+					best = v.boards[i].snapshots[v.boards[i].reading].score;
+
+			if (unthrottled)
+				sprintf(text[0], "Speed: unthrottled%s", f.paused ? " (paused)" : "");
+			else
+				sprintf(text[0], "Speed: %gx%s", speed, f.paused ? " (paused)" : "");
+			sprintf(text[1], "%d boards, %d workers", boardCount, v.workerCount);
+			sprintf(text[2], "%.0lf ticks/s, %.0lf fps", ticksPerSecond, f.framesPerSecond);
+			sprintf(text[3], "Best score: %d", best);
+			for (int i = 0; i < 4; i++)
+				lines[i] = text[i];
+			drawOverlay(win, lines, 4);
+		}
+
+		SDL_RenderPresent(win->renderer);
+	}
+
+	closeSpectator(&v);
+	SDL_DestroyTexture(target);
+	free(workers);
+	free(changed);
+	free(changedTiles);
+	free(tiles);
+	return 1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "snakeGame.h"
+#include "snakeGraphics.h"
+#include "neuralNetworkShell.h"
+#include "replay.h"
+
+#define SPECTATOR_MIN_BOARDS 1
+#define SPECTATOR_MAX_BOARDS 256
+#define SPECTATOR_WINDOW 960			//the spectator window is square, this many pixels a side
+#define SPECTATOR_TICKS_PER_SECOND 50	//game speed at a speed of 1, the same as test mode
+#define SPECTATOR_FRESH 4				//set in ready when the worker has published a snapshot the renderer hasn't seen
+
+/*
+	One of the games being watched. It is only ever touched by the worker that owns it, apart from
+	the snapshots, which are triple buffered: the worker fills snapshots[writing], then swaps it
+	with ready, and the renderer swaps ready with snapshots[reading] when the fresh bit is set.
+	Neither side ever waits for the other, and the renderer always has a whole frame to draw.
+*/
+struct spectatorBoard {
+	neuralNetwork nn;				//each board has its own copy, frontPropegation writes into it
+	int hasBrain;
+	replay* r;						//shared with other boards, only read
+	int tick;						//the next move of the replay
+
+	snake s;
+	board b;
+	int ticksSinceAteFood;
+	unsigned int random;			//seeds the next game of a brain board
+
+	boardSnapshot snapshots[3];
+	atomic_int ready;
+	int writing;
+	int reading;
+};
+typedef struct spectatorBoard spectatorBoard;
+
+struct spectator {
+	spectatorBoard* boards;
+	int boardCount;
+	replay* replays;
+	int replayCount;
+
+	pthread_t* workers;
+	int workerCount;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;			//broadcast when the speed changes, the game is paused or it is closing
+	atomic_int running;
+	atomic_int paused;
+	atomic_llong tickNanoseconds;	//time between ticks, 0 runs unthrottled
+	atomic_llong ticks;				//ticks played by every board together
+};
+typedef struct spectator spectator;
+
+int runSpectator(renderWindow*, const char*, int);
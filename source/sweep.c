@@ -0,0 +1,688 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "sweep.h"
+#include "neuralNetworkShell.h"
+#include "geneticNeuralNetwork.h"
+#include "snakeGame.h"
+#include "main.h"
+
+struct sweepValues {
+	int count;
+	int range;						//1 if values[0]..values[1] is a range for a random search
+	double values[SWEEP_MAX_VALUES];
+};
+typedef struct sweepValues sweepValues;
+
+struct sweepSpec {
+	int random;						//0 for a grid search, otherwise the number of configurations drawn
+	sweepValues mutationRates;
+	sweepValues populationSizes;
+	sweepValues tournamentSizes;
+	sweepValues fitnesses;
+	int generations;
+	int games;
+	int rung;
+	double keep;
+	int concurrent;
+	unsigned int seed;
+	char report[4096];
+};
+typedef struct sweepSpec sweepSpec;
+
+struct sweepConfig {
+	double mutation;				//the chance of each weight being mutated
+	int size;						//the population size
+	int tournament;
+	fitnessFormula fitness;
+
+	neuralNetwork** population;
+	neuralNetwork** nextPopulation;
+	double* fitnessScores;
+	double* meanScores;				//each networks mean score this generation, fitness formulas can't be compared
+	unsigned int seed;				//only used by the thread finishing a generation
+	unsigned int gameSeed;			//the seed of this generations games
+	atomic_int pending;				//tasks of this generation still to finish
+
+	int generation;					//generations played
+	int stopped;					//1 if it was stopped early
+	double bestScore;				//the best mean score of any network so far
+	double lastMeanScore;			//the mean score of the whole population in its last generation
+	long games;
+	struct timespec start;
+	double seconds;
+};
+typedef struct sweepConfig sweepConfig;
+
+struct sweepTask {
+	sweepConfig* config;
+	int start;						//the networks [start, end) of the current generation
+	int end;
+};
+typedef struct sweepTask sweepTask;
+
+//each worker has its own queue, it takes its oldest task and steals the newest from other queues
+struct sweepQueue {
+	pthread_mutex_t lock;
+	sweepTask* tasks;				//a ring
+	int start;
+	int count;
+	int capacity;
+};
+typedef struct sweepQueue sweepQueue;
+
+struct sweepPool {
+	sweepSpec* spec;
+	sweepConfig* configs;
+	int configCount;
+	int workers;
+	sweepQueue* queues;
+	atomic_int queued;				//tasks in all of the queues
+	atomic_int nextQueue;			//the queue the next task goes on, so every generation is spread over all workers
+
+	pthread_mutex_t lock;			//guards everything below
+	pthread_cond_t changed;
+	int nextConfig;
+	int activeConfigs;
+	int finishedConfigs;
+	double* rungScores;				//the best scores configurations had at each check, configCount per check
+	int* rungCounts;
+};
+typedef struct sweepPool sweepPool;
+
+static const char* fitnessNames[] = {"exponential", "score", "log"};
+
+/**
+ * @brief This function reads the values of one setting, a list or a lo..hi range
+ * @param values - where the values are stored
+ * @param text - the rest of the line after the settings name
+ * @param names - if not NULL, the values are these names rather than numbers
+ * @param nameCount - the number of names
+ * @return 1 if all went well, 0 if a value could not be read
+ */
+static int parseValues(sweepValues* values, char* text, const char** names, int nameCount) {
+	values->count = 0;
+	values->range = 0;
+
+	for (char* token = strtok(text, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+		if (values->count == SWEEP_MAX_VALUES)
+			return 0;
+
+		if (names) {
+			int found = -1;
+			for (int i = 0; i < nameCount; i++)
+				if (!strcmp(token, names[i]))
+					found = i;
+			if (found < 0)
+				return 0;
+			values->values[values->count++] = found;
+			continue;
+		}
+
+		char* dots = strstr(token, "..");
+		char* e;
+		if (dots && values->count == 0) {
+			values->values[0] = strtod(token, &e);
+			values->values[1] = strtod(dots + 2, &e);
+			values->count = 2;
+			values->range = 1;
+			continue;
+		}
+		values->values[values->count++] = strtod(token, &e);
+		if (*e)
+			return 0;
+	}
+	return values->count > 0;
+}
+
+/**
+ * @brief This function reads a sweep spec, see sweep.h
+ * @param spec - where the spec is stored
+ * @param filePath - the spec file
+ * @return 1 if all went well, 0 if the file could not be read
+ */
+static int loadSweepSpec(sweepSpec* spec, const char* filePath) {
+	memset(spec, 0, sizeof(sweepSpec));
+	spec->mutationRates = (sweepValues){1, 0, {mutationRate}};
+	spec->populationSizes = (sweepValues){1, 0, {populationSize}};
+	spec->tournamentSizes = (sweepValues){1, 0, {15}};
+	spec->fitnesses = (sweepValues){1, 0, {FITNESS_EXPONENTIAL}};
+	spec->generations = 100;
+	spec->games = 3;
+	spec->rung = 10;
+	spec->keep = 0.5;
+	spec->seed = 1;
+
+	FILE* f = fopen(filePath, "r");
+	if (f == NULL) {
+		printf("Could not open %s\n", filePath);
+		return 0;
+	}
+
+	char line[4096];
+	int lineNumber = 0;
+	int ok = 1;
+	while (ok && fgets(line, sizeof(line), f)) {
+		lineNumber++;
+		char* comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		char key[64];
+		int used;
+		if (sscanf(line, "%63s%n", key, &used) != 1)
+			continue;
+		char* rest = line + used;
+
+		if (!strcmp(key, "search")) {
+			char kind[16];
+			int count = 0;
+			ok = sscanf(rest, "%15s %d", kind, &count) >= 1 && (!strcmp(kind, "grid") || (!strcmp(kind, "random") && count > 0));
+			spec->random = !strcmp(kind, "random") ? count : 0;
+		}
+		else if (!strcmp(key, "mutation"))
+			ok = parseValues(&spec->mutationRates, rest, NULL, 0);
+		else if (!strcmp(key, "population"))
+			ok = parseValues(&spec->populationSizes, rest, NULL, 0);
+		else if (!strcmp(key, "tournament"))
+			ok = parseValues(&spec->tournamentSizes, rest, NULL, 0);
+		else if (!strcmp(key, "fitness"))
+			ok = parseValues(&spec->fitnesses, rest, fitnessNames, 3);
+		else if (!strcmp(key, "generations"))
+			ok = sscanf(rest, "%d", &spec->generations) == 1 && spec->generations > 0;
+		else if (!strcmp(key, "games"))
+			ok = sscanf(rest, "%d", &spec->games) == 1 && spec->games > 0;
+		else if (!strcmp(key, "rung"))
+			ok = sscanf(rest, "%d", &spec->rung) == 1 && spec->rung >= 0;
+		else if (!strcmp(key, "keep"))
+			ok = sscanf(rest, "%lf", &spec->keep) == 1 && spec->keep > 0 && spec->keep <= 1;
+		else if (!strcmp(key, "concurrent"))
+			ok = sscanf(rest, "%d", &spec->concurrent) == 1 && spec->concurrent >= 0;
+		else if (!strcmp(key, "seed"))
+			ok = sscanf(rest, "%u", &spec->seed) == 1;
+		else if (!strcmp(key, "report"))
+			ok = sscanf(rest, "%4095s", spec->report) == 1;
+		else
+			ok = 0;
+	}
+	fclose(f);
+
+	if (!ok) {
+		printf("Could not read line %d of %s\n", lineNumber, filePath);
+		return 0;
+	}
+	if (!spec->random && (spec->mutationRates.range || spec->populationSizes.range || spec->tournamentSizes.range)) {
+		printf("Ranges can only be used in a random search\n");
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief This function picks one value of a setting for a random search
+ * @param values - the values or range
+ * @param seed - the seed to use with rand_r
+ * @return the value
+ */
+static double drawValue(sweepValues* values, unsigned int* seed) {
+	double r = (double)rand_r(seed) / ((double)RAND_MAX + 1);
+	if (values->range)
+		return values->values[0] + r * (values->values[1] - values->values[0]);
+	return values->values[(int)(r * values->count)];
+}
+
+/**
+ * @brief This function sets a configuration, keeping the sizes in bounds
+ * @param c - the configuration
+ * @param mutation - the chance of each weight being mutated
+ * @param population - the population size
+ * @param tournament - the tournament size
+ * @param fitness - the fitnessFormula
+ * @param seed - the seed its breeding uses
+ * @return nothing
+ */
+static void setConfig(sweepConfig* c, double mutation, double population, double tournament, double fitness, unsigned int seed) {
+	memset(c, 0, sizeof(sweepConfig));
+	c->mutation = mutation < 0 ? 0 : mutation > 1 ? 1 : mutation;
+	c->size = population < 2 ? 2 : lrint(population);
+	c->tournament = tournament < 1 ? 1 : lrint(tournament);
+	c->fitness = (fitnessFormula)fitness;
+	c->seed = seed;
+}
+
+/**
+ * @brief This function works out every configuration a spec asks for
+ * @param spec - the spec
+ * @param configs - where they are stored, room for SWEEP_MAX_CONFIGS
+ * @return the number of configurations
+ */
+static int buildConfigs(sweepSpec* spec, sweepConfig* configs) {
+	unsigned int seed = spec->seed;
+	int count = 0;
+
+	if (spec->random) {
+		for (; count < spec->random && count < SWEEP_MAX_CONFIGS; count++) {
+			double mutation = drawValue(&spec->mutationRates, &seed);
+			double population = drawValue(&spec->populationSizes, &seed);
+			double tournament = drawValue(&spec->tournamentSizes, &seed);
+			double fitness = drawValue(&spec->fitnesses, &seed);
+			setConfig(&configs[count], mutation, population, tournament, fitness, rand_r(&seed));
+		}
+		return count;
+	}
+
+	for (int m = 0; m < spec->mutationRates.count; m++)
+		for (int p = 0; p < spec->populationSizes.count; p++)
+			for (int t = 0; t < spec->tournamentSizes.count; t++)
+				for (int f = 0; f < spec->fitnesses.count && count < SWEEP_MAX_CONFIGS; f++)
+					setConfig(&configs[count++], spec->mutationRates.values[m], spec->populationSizes.values[p],
+						spec->tournamentSizes.values[t], spec->fitnesses.values[f], rand_r(&seed));
+	return count;
+}
+
+/**
+ * @brief This function puts a task on a workers queue
+ * @param p - the pool
+ * @param queue - the workers queue
+ * @param task - the task
+ * @return nothing
+ */
+static void pushTask(sweepPool* p, sweepQueue* queue, sweepTask task) {
+	pthread_mutex_lock(&queue->lock);
+	if (queue->count == queue->capacity) {
+		//unwrap the ring into the bigger array
+		int capacity = queue->capacity ? queue->capacity * 2 : 64;
+		sweepTask* tasks = malloc(capacity * sizeof(sweepTask));
+		for (int i = 0; i < queue->count; i++)
+			tasks[i] = queue->tasks[(queue->start + i) % queue->capacity];
+		free(queue->tasks);
+		queue->tasks = tasks;
+		queue->start = 0;
+		queue->capacity = capacity;
+	}
+	queue->tasks[(queue->start + queue->count) % queue->capacity] = task;
+	queue->count++;
+	pthread_mutex_unlock(&queue->lock);
+
+	atomic_fetch_add(&p->queued, 1);
+}
+
+/**
+ * @brief This function takes a task, the oldest from the workers own queue, or if that is empty
+ * 		  the newest from another workers queue
+ * @param p - the pool
+ * @param worker - the worker
+ * @param task - where the task is stored
+ * @return 1 if there was a task, 0 if every queue was empty
+ */
+static int takeTask(sweepPool* p, int worker, sweepTask* task) {
+	for (int i = 0; i < p->workers; i++) {
+		sweepQueue* queue = &p->queues[(worker + i) % p->workers];
+		pthread_mutex_lock(&queue->lock);
+		if (queue->count) {
+			if (i == 0) {
+				*task = queue->tasks[queue->start];
+				queue->start = (queue->start + 1) % queue->capacity;
+			} else {
+				*task = queue->tasks[(queue->start + queue->count - 1) % queue->capacity];
+			}
+			queue->count--;
+			pthread_mutex_unlock(&queue->lock);
+			atomic_fetch_sub(&p->queued, 1);
+			return 1;
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+	return 0;
+}
+
+/**
+ * @brief This function queues a configurations next generation, split into tasks of SWEEP_CHUNK
+ * 		  networks spread over every workers queue
+ * @param p - the pool
+ * @param c - the configuration
+ * @return nothing
+ */
+static void queueGeneration(sweepPool* p, sweepConfig* c) {
+	int tasks = (c->size + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+	c->gameSeed = rand_r(&c->seed);
+	atomic_store(&c->pending, tasks);
+
+	for (int i = 0; i < tasks; i++) {
+		sweepTask task = {c, i * SWEEP_CHUNK, (i + 1) * SWEEP_CHUNK};
+		if (task.end > c->size)
+			task.end = c->size;
+		pushTask(p, &p->queues[atomic_fetch_add(&p->nextQueue, 1) % p->workers], task);
+	}
+
+	pthread_mutex_lock(&p->lock);
+	pthread_cond_broadcast(&p->changed);
+	pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * @brief This function starts configurations until as many are being trained as the spec allows
+ * @param p - the pool
+ * @return nothing
+ */
+static void startConfigs(sweepPool* p) {
+	while (1) {
+		pthread_mutex_lock(&p->lock);
+		if (p->nextConfig == p->configCount || p->activeConfigs == p->spec->concurrent) {
+			pthread_mutex_unlock(&p->lock);
+			return;
+		}
+		sweepConfig* c = &p->configs[p->nextConfig++];
+		p->activeConfigs++;
+		pthread_mutex_unlock(&p->lock);
+
+		c->population = calloc(c->size, sizeof(neuralNetwork*));
+		c->nextPopulation = calloc(c->size, sizeof(neuralNetwork*));
+		c->fitnessScores = calloc(c->size, sizeof(double));
+		c->meanScores = calloc(c->size, sizeof(double));
+		for (int i = 0; i < c->size; i++) {
+			c->population[i] = calloc(1, sizeof(neuralNetwork));
+			c->nextPopulation[i] = calloc(1, sizeof(neuralNetwork));
+			initialiseNetworkBrain(c->population[i]);
+			initialiseNetworkBrain(c->nextPopulation[i]);
+			randomiseNetwork(c->population[i]);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &c->start);
+		queueGeneration(p, c);
+	}
+}
+
+/**
+ * @brief This function frees a configurations population once it has finished, and starts the
+ * 		  next configuration waiting in its place
+ * @param p - the pool
+ * @param c - the configuration
+ * @return nothing
+ */
+static void finishConfig(sweepPool* p, sweepConfig* c) {
+	struct timespec finish;
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	c->seconds = (finish.tv_sec - c->start.tv_sec) + (finish.tv_nsec - c->start.tv_nsec) / 1e9;
+
+	for (int i = 0; i < c->size; i++) {
+		destroyBrainData(c->population[i]);
+		destroyBrainData(c->nextPopulation[i]);
+		free(c->population[i]);
+		free(c->nextPopulation[i]);
+	}
+	free(c->population);
+	free(c->nextPopulation);
+	free(c->fitnessScores);
+	free(c->meanScores);
+
+	pthread_mutex_lock(&p->lock);
+	p->activeConfigs--;
+	p->finishedConfigs++;
+	pthread_cond_broadcast(&p->changed);
+	pthread_mutex_unlock(&p->lock);
+
+	startConfigs(p);
+}
+
+/**
+ * @brief This function decides whether a configuration carries on at an early stopping check. Each
+ * 		  one is compared with those that reached the same check before it, so no configuration
+ * 		  waits for the others, and it carries on if it is in the best keep of them.
+ * @param p - the pool
+ * @param c - the configuration, it has just played a multiple of rung generations
+ * @return 1 if it should be stopped, 0 otherwise
+ */
+static int stopEarly(sweepPool* p, sweepConfig* c) {
+	sweepSpec* spec = p->spec;
+	if (!spec->rung || c->generation % spec->rung || c->generation >= spec->generations)
+		return 0;
+
+	int rung = c->generation / spec->rung - 1;
+	double* scores = &p->rungScores[(size_t)rung * p->configCount];
+
+	pthread_mutex_lock(&p->lock);
+	int count = ++p->rungCounts[rung];
+	scores[count - 1] = c->bestScore;
+	int better = 0;
+	for (int i = 0; i < count; i++)
+		better += scores[i] > c->bestScore;
+	pthread_mutex_unlock(&p->lock);
+
+	//until enough configurations have got this far there is nothing to compare with
+	return count >= ceil(1 / spec->keep) && better >= ceil(count * spec->keep);
+}
+
+/**
+ * @brief This function is run by whichever thread finishes the last task of a generation. It
+ * 		  breeds the next generation the same way trainNetwork does and queues it.
+ * @param p - the pool
+ * @param c - the configuration
+ * @return nothing
+ */
+static void finishGeneration(sweepPool* p, sweepConfig* c) {
+	double total = 0;
+	for (int i = 0; i < c->size; i++) {
+		total += c->meanScores[i];
+		if (c->meanScores[i] > c->bestScore)
+			c->bestScore = c->meanScores[i];
+	}
+	c->lastMeanScore = total / c->size;
+	c->games += (long)c->size * p->spec->games;
+	c->generation++;
+
+	if (stopEarly(p, c)) {
+		c->stopped = 1;
+		finishConfig(p, c);
+		return;
+	}
+	if (c->generation == p->spec->generations) {
+		finishConfig(p, c);
+		return;
+	}
+
+	for (int j = 0; j < c->size - 1; j++) {
+		mateWith(
+			c->population[selectParentFrom(c->fitnessScores, c->size, c->tournament, &c->seed)],
+			c->population[selectParentFrom(c->fitnessScores, c->size, c->tournament, &c->seed)],
+			c->nextPopulation[j],
+			&c->seed
+		);
+		mutateWith(c->nextPopulation[j], c->mutation, &c->seed);
+	}
+
+	int bestBrain = 0;
+	for (int i = 1; i < c->size; i++)
+		if (c->fitnessScores[i] >= c->fitnessScores[bestBrain])
+			bestBrain = i;
+
+	deepCopy(c->population[bestBrain], c->population[0]);
+	for (int j = 0; j < c->size - 1; j++)
+		deepCopy(c->nextPopulation[j], c->population[j+1]);
+
+	queueGeneration(p, c);
+}
+
+/**
+ * @brief This function plays the games of one task, and finishes the generation if it was the last task
+ * @param p - the pool
+ * @param task - the task
+ * @return nothing
+ */
+static void runTask(sweepPool* p, sweepTask* task) {
+	sweepConfig* c = task->config;
+	int games = p->spec->games;
+	snake s;
+	board b;
+
+	for (int i = task->start; i < task->end; i++) {
+		double fitness = 0;
+		double score = 0;
+		for (int g = 0; g < games; g++) {
+			b.seed = c->gameSeed + i * games + g;
+			playCompTrain(c->population[i], &s, &b, NULL, NULL);
+			fitness += gameFitness(&s, c->fitness);
+			score += s.score;
+			free(s.x);
+			free(s.y);
+		}
+		c->fitnessScores[i] = fitness / games;
+		c->meanScores[i] = score / games;
+	}
+
+	if (atomic_fetch_sub(&c->pending, 1) == 1)
+		finishGeneration(p, c);
+}
+
+/**
+ * @brief This function is run by each worker thread, it runs tasks until every configuration has finished
+ * @param arg - the pool and the workers number
+ * @return nothing
+ */
+static void* sweepWorker(void* arg) {
+	sweepPool* p = ((void**)arg)[0];
+	int worker = (int)(size_t)((void**)arg)[1];
+	free(arg);
+
+	sweepTask task;
+	while (1) {
+		if (takeTask(p, worker, &task)) {
+			runTask(p, &task);
+			continue;
+		}
+
+		pthread_mutex_lock(&p->lock);
+		while (!atomic_load(&p->queued) && p->finishedConfigs < p->configCount)
+			pthread_cond_wait(&p->changed, &p->lock);
+		int finished = p->finishedConfigs == p->configCount;
+		pthread_mutex_unlock(&p->lock);
+
+		if (finished)
+			return NULL;
+	}
+}
+
+static int compareConfigs(const void* a, const void* b) {
+	const sweepConfig* x = a;
+	const sweepConfig* y = b;
+	if (x->bestScore != y->bestScore)
+		return x->bestScore < y->bestScore ? 1 : -1;
+	if (x->lastMeanScore != y->lastMeanScore)
+		return x->lastMeanScore < y->lastMeanScore ? 1 : -1;
+	return 0;
+}
+
+/**
+ * @brief This function prints the results, best first, and writes them to the specs report file
+ * @param spec - the spec
+ * @param configs - the finished configurations
+ * @param count - the number of configurations
+ * @return nothing
+ */
+static void reportSweep(sweepSpec* spec, sweepConfig* configs, int count) {
+	qsort(configs, count, sizeof(sweepConfig), compareConfigs);
+
+	printf("%-6s %10s %10s %10s %-12s %11s %10s %10s %10s\n",
+		"Rank", "Mutation", "Population", "Tournament", "Fitness", "Generations", "Best", "Mean", "Seconds");
+	for (int i = 0; i < count; i++) {
+		sweepConfig* c = &configs[i];
+		printf("%-6d %10.4lf %10d %10d %-12s %11d %10.2lf %10.2lf %10.1lf%s\n", i+1, c->mutation, c->size,
+			c->tournament, fitnessNames[c->fitness], c->generation, c->bestScore, c->lastMeanScore, c->seconds,
+			c->stopped ? " stopped early" : "");
+	}
+
+	if (!spec->report[0])
+		return;
+	FILE* f = fopen(spec->report, "w");
+	if (f == NULL) {
+		printf("Could not write %s\n", spec->report);
+		return;
+	}
+	fprintf(f, "rank,mutation,population,tournament,fitness,generations,stopped,best,mean,games,seconds\n");
+	for (int i = 0; i < count; i++) {
+		sweepConfig* c = &configs[i];
+		fprintf(f, "%d,%lf,%d,%d,%s,%d,%d,%lf,%lf,%ld,%lf\n", i+1, c->mutation, c->size, c->tournament,
+			fitnessNames[c->fitness], c->generation, c->stopped, c->bestScore, c->lastMeanScore, c->games, c->seconds);
+	}
+	fclose(f);
+	printf("Written to %s\n", spec->report);
+}
+
+/**
+ * @brief This function trains every configuration a spec asks for at the same time, on one pool of
+ * 		  worker threads. Each generation is split into tasks spread over the workers, so the
+ * 		  configurations are interleaved and a worker that runs out steals from the others.
+ * 		  Configurations that fall behind at an early stopping check are stopped to make room.
+ * @param filePath - the spec file, see sweep.h
+ * @param threads - the number of worker threads, 0 uses one per core
+ * @return 1 if all went well, 0 if the spec could not be read
+ */
+int runSweep(const char* filePath, int threads) {
+	sweepSpec spec;
+	if (!loadSweepSpec(&spec, filePath))
+		return 0;
+
+	sweepPool p = {0};
+	p.spec = &spec;
+	p.configs = calloc(SWEEP_MAX_CONFIGS, sizeof(sweepConfig));
+	p.configCount = buildConfigs(&spec, p.configs);
+
+	p.workers = threads > 0 ? threads : sysconf(_SC_NPROCESSORS_ONLN);
+	if (spec.concurrent <= 0)
+		spec.concurrent = p.workers * 2;
+	p.queues = calloc(p.workers, sizeof(sweepQueue));
+	for (int i = 0; i < p.workers; i++)
+		pthread_mutex_init(&p.queues[i].lock, NULL);
+	pthread_mutex_init(&p.lock, NULL);
+	pthread_cond_init(&p.changed, NULL);
+
+	int rungs = spec.rung ? spec.generations / spec.rung + 1 : 0;
+	p.rungScores = calloc((size_t)rungs * p.configCount + 1, sizeof(double));
+	p.rungCounts = calloc(rungs + 1, sizeof(int));
+
+	printf("Sweeping %d configurations, %d at a time, on %d threads\n", p.configCount, spec.concurrent, p.workers);
+
+	struct timespec start, finish;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	startConfigs(&p);
+	pthread_t* workers = calloc(p.workers, sizeof(pthread_t));
+	for (int i = 0; i < p.workers; i++) {
+		void** arg = malloc(2 * sizeof(void*));
+		arg[0] = &p;
+		arg[1] = (void*)(size_t)i;
+		pthread_create(&workers[i], NULL, sweepWorker, arg);
+	}
+	for (int i = 0; i < p.workers; i++)
+		pthread_join(workers[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	double seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+
+	long games = 0;
+	for (int i = 0; i < p.configCount; i++)
+		games += p.configs[i].games;
+
+	reportSweep(&spec, p.configs, p.configCount);
+	printf("Swept %d configurations, %ld games on %d threads in %.2lfs, %.0lf games/s\n",
+		p.configCount, games, p.workers, seconds, games / seconds);
+
+	for (int i = 0; i < p.workers; i++) {
+		pthread_mutex_destroy(&p.queues[i].lock);
+		free(p.queues[i].tasks);
+	}
+	pthread_mutex_destroy(&p.lock);
+	pthread_cond_destroy(&p.changed);
+	free(p.queues);
+	free(p.rungScores);
+	free(p.rungCounts);
+	free(p.configs);
+	free(workers);
+	return 1;
+}
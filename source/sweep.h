@@ -0,0 +1,26 @@
+#pragma once
+
+#define SWEEP_MAX_VALUES 16				//values one parameter can be listed with
+#define SWEEP_MAX_CONFIGS 4096
+#define SWEEP_CHUNK 32					//networks played by one task
+
+/*
+	A sweep spec is a text file, one setting per line, # starts a comment:
+
+		search grid					grid tries every combination, random N draws N of them
+		mutation 0.01 0.05 0.25		any number of values, or for a random search lo..hi
+		population 500 2000
+		tournament 5 15
+		fitness exponential score log
+		generations 100				the most a configuration is trained for
+		games 3						games per network per generation
+		rung 10						generations between early stopping checks, 0 never stops early
+		keep 0.5					the fraction of configurations that carry on at each check
+		concurrent 8				configurations trained at once, 0 for two per thread
+		seed 1
+		report sweep.csv			if set, the results are written here too
+
+	Anything left out is what train uses.
+*/
+
+int runSweep(const char*, int);